@@ -2,13 +2,15 @@
 
 #include <vector>
 #include <string>
-#include <memory>
+#include <utility>
 
+// Every node is made in the Arena of the parse that produced it and freed 
+// with that arena, so node pointers are plain, non-owning pointers.
 struct Expr;
 struct Stmt;
 
-using ExprPtr = std::shared_ptr<Expr>;
-using StmtPtr = std::shared_ptr<Stmt>;
+using ExprPtr = Expr*;
+using StmtPtr = Stmt*;
 
 using ExprList = std::vector<ExprPtr>;
 using StmtList = std::vector<StmtPtr>;
@@ -33,7 +35,7 @@ struct Parameter {
 using ParameterList = std::vector<Parameter>;
 
 struct Target;
-using TargetPtr = std::shared_ptr<Target>;
+using TargetPtr = Target*;
 using TargetList = std::vector<TargetPtr>;
 
 enum class TargetKind {
@@ -63,3 +65,4 @@ struct ExprTarget : public Target {
 
 #include "expr.h"
 #include "stmt.h"
+#include "visitor.h"
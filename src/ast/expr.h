@@ -32,6 +32,8 @@ struct Expr {
     bool await {false};
     Location location;
     ExprKind kind;
+    SourceRange range; // without the "await", if any
+    bool dirty {false}; // set by a pass that changes the node
 };
 
 struct NameExpr : public Expr {
@@ -46,19 +48,21 @@ struct StringLiteralExpr : public Expr {
         : Expr(std::move(location), ExprKind::StringLiteral) {}
     bool isBytes {false};
     std::string value;
+    std::string text; // the literals as written, when 'value' cannot hold them
 };
 
 struct IntegerLiteralExpr : public Expr {
     IntegerLiteralExpr(const Location& location)
         : Expr(location, ExprKind::IntegerLiteral) {}
-    int64_t value;
+    int64_t value {0};
+    std::string text; // the literal as written, when 'value' cannot hold it
 };
 
 struct FloatLiteralExpr : public Expr {
     FloatLiteralExpr(const Location& location)
         : Expr(location, ExprKind::FloatLiteral) {}
     bool isImaginary {false};
-    long double value;
+    double value {0};
 };
 
 struct BooleanLiteralExpr : public Expr {
@@ -71,9 +75,9 @@ struct CompIf;
 struct CompFor;
 struct CompIter;
 
-using CompIfPtr = std::shared_ptr<CompIf>;
-using CompForPtr = std::shared_ptr<CompFor>;
-using CompIterPtr = std::shared_ptr<CompIter>;
+using CompIfPtr = CompIf*;
+using CompForPtr = CompFor*;
+using CompIterPtr = CompIter*;
 
 struct CompFor {
     bool isAsync {false};
@@ -97,7 +101,7 @@ struct Comprehension {
     CompForPtr compFor;
 };
 
-using ComprehensionPtr = std::shared_ptr<Comprehension>;
+using ComprehensionPtr = Comprehension*;
 
 struct ListDisplayExpr : public Expr {
     ListDisplayExpr(const Location& location)
@@ -197,6 +201,9 @@ struct BinaryExpr : public Expr {
     ExprPtr lhs;
     ExprPtr rhs;
     TokenKind op;
+    // a comparison that carries on the one on its left, as the second '<' 
+    // of a<b<c does; (a<b)<c is no chain
+    bool continuesChain {false};
 };
 
 struct LambdaExpr : public Expr {
@@ -28,14 +28,43 @@ enum class StmtKind {
     With,
     Funcdef,
     Classdef,
+
+    // a statement that could not be parsed
+    Error,
 };
 
+// statements that end with a suite
+inline bool isCompoundStmt(StmtKind kind) {
+    switch (kind) {
+    case StmtKind::If:
+    case StmtKind::While:
+    case StmtKind::For:
+    case StmtKind::Try:
+    case StmtKind::With:
+    case StmtKind::Funcdef:
+    case StmtKind::Classdef:
+        return true;
+    default:
+        return false;
+    }
+}
+
 struct Stmt {
     Stmt(Location location, StmtKind kind)
         : location(std::move(location)), 
         kind(kind) {}
     StmtKind kind;
     Location location;
+    SourceRange range; // from the first token to the last, ';' aside
+    bool dirty {false}; // set by a pass that changes the node
+};
+
+// What the parser leaves in place of a statement with a syntax error, when 
+// it is recovering from errors. 'text' is the source that was skipped.
+struct ErrorStmt : public Stmt {
+    ErrorStmt(const Location& location)
+        : Stmt(location, StmtKind::Error) {}
+    std::string text;
 };
 
 struct ExprStmt : public Stmt {
@@ -198,15 +227,42 @@ struct Decorator {
 
 using DecoratorList = std::vector<Decorator>;
 
+// A function body that a lazy parse stepped over instead of parsing; the 
+// parser makes it, and parses the body into a suite when asked to.
+class LazySuite {
+public:
+    virtual void parseInto(Suite& suite) = 0;
+
+protected:
+    ~LazySuite() = default;
+};
+
 struct FuncdefStmt : public Stmt {
     FuncdefStmt(const Location& location)
         : Stmt(location, StmtKind::Funcdef) {}
+
+    // The body. After a lazy parse it is parsed here, the first time it is 
+    // asked for; syntax errors in it go to the diagnostics of that parse, 
+    // and without error recovery the first one is thrown from here.
+    Suite& getSuite() const {
+        if (lazySuite) {
+            std::exchange(lazySuite, nullptr)->parseInto(suite);
+        }
+        return suite;
+    }
+
+    // whether the body is still waiting for getSuite() to parse it
+    bool isSuiteParsed() const {
+        return lazySuite == nullptr;
+    }
+
     bool isAsync {false};
     DecoratorList decorators;
     std::string name;
     ParameterList parameterList;
     ExprPtr hint {nullptr}; // -> xx
-    Suite suite;
+    mutable Suite suite; // through getSuite()
+    mutable LazySuite* lazySuite {nullptr};
 };
 
 struct ClassdefStmt : public Stmt {
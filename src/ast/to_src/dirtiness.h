@@ -0,0 +1,48 @@
+#pragma once
+
+// Marks every node with a dirty node under it as dirty too, so that the 
+// transformer only copies the source of subtrees that no pass has touched. 
+// Nodes without a source range were made up by a pass, and count as dirty.
+class DirtinessPropagator : public AstWalker<DirtinessPropagator> {
+public:
+    void visitExpr(Expr& expr) {
+        bool outerFoundDirty = foundDirty;
+        foundDirty = false;
+
+        AstWalker::visitExpr(expr);
+
+        expr.dirty = expr.dirty || foundDirty || expr.range.isEmpty();
+        foundDirty = outerFoundDirty || expr.dirty;
+    }
+
+    void visitStmt(Stmt& stmt) {
+        bool outerFoundDirty = foundDirty;
+        foundDirty = false;
+
+        AstWalker::visitStmt(stmt);
+
+        stmt.dirty = stmt.dirty || foundDirty || stmt.range.isEmpty();
+        foundDirty = outerFoundDirty || stmt.dirty;
+    }
+
+    // a body no one has asked for yet cannot have been changed, and is 
+    // left unparsed
+    void visitFuncdefStmt(FuncdefStmt& stmt) {
+        walk(stmt.decorators);
+        walk(stmt.parameterList);
+        walk(stmt.hint);
+
+        if (stmt.isSuiteParsed()) {
+            walk(stmt.suite);
+        }
+    }
+
+private:
+    bool foundDirty {false};
+};
+
+// to be run after the passes and before the transformer
+inline void propagateDirtiness(StmtList& stmts) {
+    DirtinessPropagator propagator;
+    propagator.walk(stmts);
+}
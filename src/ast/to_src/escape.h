@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <string_view>
+
+// How each byte is written inside a double-quoted literal: 0 when it is 
+// written as it is, the letter of its short escape ('n' for "\n"), or 'x' 
+// for a "\xhh" escape. Bytes from 0x80 up are utf8 in strings and are kept; 
+// in bytes literals they are escaped.
+constexpr std::array<char, 256> makeEscapeTable(bool escapeHighBytes) {
+    std::array<char, 256> table {};
+
+    for (int c = 0; c < 256; ++c) {
+        if ((c < 0x20) || (c == 0x7f) || (escapeHighBytes && (c >= 0x80))) {
+            table[c] = 'x';
+        }
+    }
+
+    table['\t'] = 't';
+    table['\n'] = 'n';
+    table['\r'] = 'r';
+    table['"'] = '"';
+    table['\\'] = '\\';
+
+    return table;
+}
+
+inline constexpr auto stringEscapeTable = makeEscapeTable(false);
+inline constexpr auto bytesEscapeTable = makeEscapeTable(true);
+
+/**
+ * @brief      Appends text in the form it takes between double quotes. 
+ *             Runs that need no escaping are found with findEscapeByte and 
+ *             copied whole.
+ *
+ * @param      out      Where to append.
+ * @param[in]  text     The decoded value of the literal.
+ * @param[in]  isBytes  Whether the literal is a bytes literal.
+ */
+inline void appendEscapedText(
+    std::string& out, 
+    std::string_view text, 
+    bool isBytes
+) {
+    static constexpr char hexDigits[] = "0123456789abcdef";
+    const auto& table = isBytes ? bytesEscapeTable : stringEscapeTable;
+
+    auto position = text.data();
+    auto end = position + text.size();
+
+    while (position != end) {
+        auto special = findEscapeByte(position, end, isBytes);
+        out.append(position, special - position);
+
+        if (special == end) {
+            break;
+        }
+
+        auto byte = static_cast<unsigned char>(*special);
+        auto escape = table[byte];
+
+        if (escape == 'x') {
+            const char sequence[] = {
+                '\\', 'x', hexDigits[byte >> 4], hexDigits[byte & 0xf]
+            };
+            out.append(sequence, sizeof(sequence));
+        }
+        else {
+            const char sequence[] = { '\\', escape };
+            out.append(sequence, sizeof(sequence));
+        }
+
+        position = special + 1;
+    }
+}
@@ -1,134 +1,146 @@
 #pragma once
 
 void PythonAstTransformer::transformExpr(ExprPtr expr) {
+    mapLocation(expr->location);
+
     if (expr->await) {
         addText("await ");
     }
 
-    switch (expr->kind) {
-    case ExprKind::None: {
-        addText("None");
-        break;
-    }
-    case ExprKind::Name: {
-        transformNameExpr(
-            *std::static_pointer_cast<NameExpr>(expr)
-        );
-        break;
-    }
-    case ExprKind::StringLiteral: {
-        transformStringLiteralExpr(
-            *std::static_pointer_cast<StringLiteralExpr>(expr)
-        );
-        break;
-    }
-    case ExprKind::IntegerLiteral: {
-        transformIntegerLiteralExpr(
-            *std::static_pointer_cast<IntegerLiteralExpr>(expr)
-        );
-        break;
-    }
-    case ExprKind::BooleanLiteral: {
-        transformBooleanLiteralExpr(
-            *std::static_pointer_cast<BooleanLiteralExpr>(expr)
-        );
-        break;
-    }
-    case ExprKind::FloatLiteral: {
-        transformFloatLiteralExpr(
-            *std::static_pointer_cast<FloatLiteralExpr>(expr)
-        );
-        break;
-    }
-    case ExprKind::If: {
-        transformIfExpr(
-            *std::static_pointer_cast<IfExpr>(expr)
-        );
-        break;
-    }
-    case ExprKind::ListDisplay: {
-        transformListDisplayExpr(
-            *std::static_pointer_cast<ListDisplayExpr>(expr)
-        );
-        break;
-    }
-    case ExprKind::TupleDisplay: {
-        transformTupleDisplayExpr(
-            *std::static_pointer_cast<TupleDisplayExpr>(expr)
-        );
-        break;
-    }
-    case ExprKind::DictDisplay: {
-        transformDictDisplayExpr(
-            *std::static_pointer_cast<DictDisplayExpr>(expr)
-        );
-        break;
-    }
-    case ExprKind::SetDisplay: {
-        transformSetDisplayExpr(
-            *std::static_pointer_cast<SetDisplayExpr>(expr)
-        );
-        break;
-    }
-    case ExprKind::Generator: {
-        transformGeneratorExpr(
-            *std::static_pointer_cast<GeneratorExpr>(expr)
-        );
-        break;
-    }
-    case ExprKind::Yield: {
-        transformYieldExpr(
-            *std::static_pointer_cast<YieldExpr>(expr)
-        );
-        break;
-    }
-    case ExprKind::AttributeRef: {
-        transformAttributeRefExpr(
-            *std::static_pointer_cast<AttributeRefExpr>(expr)
-        );
-        break;
-    }
-    case ExprKind::Subscription: {
-        transformSubscriptionExpr(
-            *std::static_pointer_cast<SubscriptionExpr>(expr)
-        );
-        break;
-    }
-    case ExprKind::Slicing: {
-        transformSlicingExpr(
-            *std::static_pointer_cast<SlicingExpr>(expr)
-        );
-        break;
-    }
-    case ExprKind::Call: {
-        transformCallExpr(
-            *std::static_pointer_cast<CallExpr>(expr)
-        );
-        break;
+    if (copyOriginal(*expr)) {
+        return;
     }
+
+    visitExpr(*expr);
+}
+
+bool PythonAstTransformer::canCopy(
+    bool dirty, 
+    const SourceRange& range
+) const {
+    return not originalSource.empty()
+        && not minify
+        && not dirty
+        && not range.isEmpty()
+        && (range.end <= originalSource.size());
+}
+
+// The copy is bracketed when it might bind more loosely than what the 
+// transformer puts around it, and when it runs over several lines, which 
+// it could only do inside brackets or after a backslash.
+bool PythonAstTransformer::copyOriginal(const Expr& expr) {
+    if (not canCopy(expr.dirty, expr.range)) {
+        return false;
+    }
+
+    auto text = originalSource.substr(
+        expr.range.begin, 
+        expr.range.end - expr.range.begin
+    );
+
+    bool needsBrackets = (expr.kind == ExprKind::Binary)
+        || (expr.kind == ExprKind::Unary)
+        || (expr.kind == ExprKind::If)
+        || (expr.kind == ExprKind::Lambda)
+        || (text.find('\n') != std::string_view::npos);
+
+    if (needsBrackets) {
+        addText("(");
+    }
+
+    addText(text);
+
+    if (needsBrackets) {
+        addText(")");
+    }
+
+    return true;
+}
+
+void PythonAstTransformer::transformOperand(
+    ExprPtr expr,
+    Precedence minimum
+) {
+    // normal output brackets every binary expression itself, and a unary 
+    // one only where its place needs it, as (-a)**b does
+    auto bracketed = (minify || (expr->kind == ExprKind::Unary)) 
+        && (getPrecedence(*expr) < minimum);
+
+    if (not bracketed) {
+        transformExpr(expr);
+        return;
+    }
+
+    addText("(");
+    transformExpr(expr);
+    addText(")");
+}
+
+PythonAstTransformer::Precedence PythonAstTransformer::getPrecedence(
+    const Expr& expr
+) {
+    switch (expr.kind) {
+    case ExprKind::Yield:
+        return YieldLevel;
+    case ExprKind::Lambda:
+        return LambdaLevel;
+    case ExprKind::If:
+        return IfLevel;
     case ExprKind::Unary: {
-        transformUnaryExpr(
-            *std::static_pointer_cast<UnaryExpr>(expr)
-        );
-        break;
-    }
-    case ExprKind::Binary: {
-        transformBinaryExpr(
-            *std::static_pointer_cast<BinaryExpr>(expr)
-        );
-        break;
-    }
-    case ExprKind::Lambda: {
-        transformLambdaExpr(
-            *std::static_pointer_cast<LambdaExpr>(expr)
-        );
-        break;
+        auto op = static_cast<const UnaryExpr&>(expr).op;
+        return op == TokenKind::ConditionalNot ? NotLevel : UnaryLevel;
     }
+    case ExprKind::Binary:
+        return getPrecedence(static_cast<const BinaryExpr&>(expr).op);
+    case ExprKind::Await:
+        return AwaitLevel;
     default:
-        assert(0);
+        return expr.await ? AwaitLevel : PrimaryLevel;
     }
 }
 
+PythonAstTransformer::Precedence PythonAstTransformer::getPrecedence(
+    TokenKind op
+) {
+    switch (op) {
+    case TokenKind::ConditionalOr:
+        return OrLevel;
+    case TokenKind::ConditionalAnd:
+        return AndLevel;
+    case TokenKind::LogicalOr:
+        return BitwiseOrLevel;
+    case TokenKind::LogicalXor:
+        return BitwiseXorLevel;
+    case TokenKind::LogicalAnd:
+        return BitwiseAndLevel;
+    case TokenKind::LogicalLeftShift:
+    case TokenKind::LogicalRightShift:
+        return ShiftLevel;
+    case TokenKind::ArithmeticAdd:
+    case TokenKind::ArithmeticSub:
+        return AdditiveLevel;
+    case TokenKind::ArithmeticMul:
+    case TokenKind::ArithmeticDiv:
+    case TokenKind::ArithmeticFloorDiv:
+    case TokenKind::ArithmeticMod:
+    case TokenKind::At:
+        return MultiplicativeLevel;
+    case TokenKind::ArithmeticPow:
+        return PowerLevel;
+    default:
+        return ComparisonLevel;
+    }
+}
+
+void PythonAstTransformer::visitNoneExpr(const Expr&) {
+    addText("None");
+}
+
+void PythonAstTransformer::visitAwaitExpr(const AwaitExpr& expr) {
+    addText("await ");
+    transformOperand(expr.primary, PrimaryLevel);
+}
+
 void PythonAstTransformer::transformArgument(const Argument& argument) {
     for(int i = 0; i < argument.stars; ++i) {
         addText("*");
@@ -144,40 +156,48 @@ void PythonAstTransformer::transformArgument(const Argument& argument) {
     transformExpr(argument.value);
 }
 
-void PythonAstTransformer::transformNameExpr(
+void PythonAstTransformer::visitNameExpr(
     const NameExpr& expr
 ) {
     addText(expr.value);
 }
 
-void PythonAstTransformer::transformStringLiteralExpr(
+void PythonAstTransformer::visitStringLiteralExpr(
     const StringLiteralExpr& expr
 ) {
-    addText("\"");
-
-    auto temp = std::regex_replace(expr.value, std::regex("\""), "\\\"");
-    temp = std::regex_replace(temp, std::regex("\n"), "\\n");
+    if (not expr.text.empty()) {
+        addText(expr.text);
+        return;
+    }
 
-    addText(temp);
+    addText(expr.isBytes ? "b\"" : "\"");
+    appendEscapedText(buffer, expr.value, expr.isBytes);
     addText("\"");
 }
 
-void PythonAstTransformer::transformIntegerLiteralExpr(
+void PythonAstTransformer::visitIntegerLiteralExpr(
     const IntegerLiteralExpr& expr
 ) {
-    addText(formatAsString(expr.value));
+    if (not expr.text.empty()) {
+        addText(expr.text);
+        return;
+    }
+
+    char digits[maxFormattedNumberLength];
+    addText(formatIntegerLiteral(digits, expr.value));
 }
 
-void PythonAstTransformer::transformBooleanLiteralExpr(
+void PythonAstTransformer::visitBooleanLiteralExpr(
     const BooleanLiteralExpr& expr
 ) {
     addText(expr.value == true ? "True" : "False");
 }
 
-void PythonAstTransformer::transformFloatLiteralExpr(
+void PythonAstTransformer::visitFloatLiteralExpr(
     const FloatLiteralExpr& expr
 ) {
-    addText(formatAsString(expr.value));
+    char digits[maxFormattedNumberLength];
+    addText(formatFloatLiteral(digits, expr.value, expr.isImaginary));
 }
 
 void PythonAstTransformer::transformComprehension(
@@ -202,14 +222,14 @@ void PythonAstTransformer::transformComprehensionFor(
     while (i < compFor.targetList.size()) {
         transformTarget(compFor.targetList[i]);
         if (i != compFor.targetList.size() - 1) {
-            addText(", ");
+            addText(", ", ",");
         }
         i++;
     }
 
     addText(" in ");
 
-    transformExpr(compFor.test);
+    transformOperand(compFor.test, OrLevel);
 
     if (compFor.compIter) {
         transformComprehensionIter(*(compFor.compIter));
@@ -219,7 +239,7 @@ void PythonAstTransformer::transformComprehensionFor(
 void PythonAstTransformer::transformComprehensionIf(
     const CompIf& compIf
 ) {
-    transformExpr(compIf.exprNoCond);
+    transformOperand(compIf.exprNoCond, OrLevel);
     addText(" ");
 
     if (compIf.compIter) {
@@ -238,7 +258,7 @@ void PythonAstTransformer::transformComprehensionIter(
     }
 }
 
-void PythonAstTransformer::transformListDisplayExpr(
+void PythonAstTransformer::visitListDisplayExpr(
     const ListDisplayExpr& expr
 ) {
     addText("[");
@@ -253,7 +273,7 @@ void PythonAstTransformer::transformListDisplayExpr(
     while (i < expr.starredList.size()) {
         transformExpr(expr.starredList[i]);
         if (i != expr.starredList.size() - 1) {
-            addText(", ");
+            addText(", ", ",");
         }
 
         i++;
@@ -263,7 +283,7 @@ void PythonAstTransformer::transformListDisplayExpr(
 
 }
 
-void PythonAstTransformer::transformTupleDisplayExpr(
+void PythonAstTransformer::visitTupleDisplayExpr(
     const TupleDisplayExpr& expr
 ) {
     addText("(");
@@ -273,7 +293,7 @@ void PythonAstTransformer::transformTupleDisplayExpr(
         transformExpr(expr.items[i]);
 
         if (i != expr.items.size() - 1) {
-            addText(", ");
+            addText(", ", ",");
         }
 
         i++;
@@ -283,8 +303,8 @@ void PythonAstTransformer::transformTupleDisplayExpr(
 }
 
 void PythonAstTransformer::transformDictItem(const DictItem& item) {
-    transformExpr(item.expr1);
-    addText(": ");
+    transformOperand(item.expr1, IfLevel);
+    addText(": ", ":");
     transformExpr(item.expr2);
 
     if (item.compFor) {
@@ -293,15 +313,15 @@ void PythonAstTransformer::transformDictItem(const DictItem& item) {
     }
 }
 
-void PythonAstTransformer::transformIfExpr(const IfExpr& expr) {
-    transformExpr(expr.cond);
+void PythonAstTransformer::visitIfExpr(const IfExpr& expr) {
+    transformOperand(expr.thenValue, OrLevel);
     addText(" if ");
-    transformExpr(expr.thenValue);
+    transformOperand(expr.cond, OrLevel);
     addText(" else ");
-    transformExpr(expr.elseValue);
+    transformOperand(expr.elseValue, OrLevel);
 }
 
-void PythonAstTransformer::transformDictDisplayExpr(
+void PythonAstTransformer::visitDictDisplayExpr(
     const DictDisplayExpr& expr
 ) {
     addText("{");
@@ -311,7 +331,7 @@ void PythonAstTransformer::transformDictDisplayExpr(
         transformDictItem(expr.itemList[i]);
 
         if (i != expr.itemList.size() - 1) {
-            addText(", ");
+            addText(", ", ",");
         }
 
         i++;
@@ -320,7 +340,7 @@ void PythonAstTransformer::transformDictDisplayExpr(
     addText("}");
 }
 
-void PythonAstTransformer::transformSetDisplayExpr(
+void PythonAstTransformer::visitSetDisplayExpr(
     const SetDisplayExpr& expr
 ) {
     addText("{");
@@ -337,7 +357,7 @@ void PythonAstTransformer::transformSetDisplayExpr(
         transformExpr(expr.items[i]);
 
         if (i != expr.items.size() - 1) {
-            addText(", ");
+            addText(", ", ",");
         }
 
         i++;
@@ -346,7 +366,7 @@ void PythonAstTransformer::transformSetDisplayExpr(
     addText("}");
 }
 
-void PythonAstTransformer::transformGeneratorExpr(
+void PythonAstTransformer::visitGeneratorExpr(
     const GeneratorExpr& expr
 ) {
     addText("(");
@@ -356,21 +376,25 @@ void PythonAstTransformer::transformGeneratorExpr(
     addText(")");
 }
 
-void PythonAstTransformer::transformYieldExpr(
+void PythonAstTransformer::visitYieldExpr(
     const YieldExpr& expr
 ) {
-    addText("yield ");
+    addText("yield ", "yield");
 
     if (expr.exprList.size() == 0) {
         return;
     }
 
+    if (minify) {
+        addText(" ");
+    }
+
     int i = 0;
 
     while (i < expr.exprList.size()) {
         transformExpr(expr.exprList[i]);
         if (i != expr.exprList.size() - 1) {
-            addText(", ");
+            addText(", ", ",");
         }
         i++;
     }
@@ -381,18 +405,18 @@ void PythonAstTransformer::transformYieldExpr(
     }
 }
 
-void PythonAstTransformer::transformAttributeRefExpr(
+void PythonAstTransformer::visitAttributeRefExpr(
     const AttributeRefExpr& expr
 ) {
-    transformExpr(expr.primary);
+    transformOperand(expr.primary, PrimaryLevel);
     addText(".");
     addText(expr.name);
 }
 
-void PythonAstTransformer::transformSubscriptionExpr(
+void PythonAstTransformer::visitSubscriptionExpr(
     const SubscriptionExpr& expr
 ) {
-    transformExpr(expr.primary);
+    transformOperand(expr.primary, PrimaryLevel);
 
     addText("[");
     int i = 0;
@@ -401,7 +425,7 @@ void PythonAstTransformer::transformSubscriptionExpr(
         transformExpr(expr.exprList[i]);
 
         if (i != expr.exprList.size() - 1) {
-            addText(", ");
+            addText(", ", ",");
         }
 
         i++;
@@ -410,35 +434,36 @@ void PythonAstTransformer::transformSubscriptionExpr(
     addText("]");
 }
 
-void PythonAstTransformer::transformSlicingExpr(
+void PythonAstTransformer::visitSlicingExpr(
     const SlicingExpr& expr
 ) {
-    transformExpr(expr.primary);
+    transformOperand(expr.primary, PrimaryLevel);
     addText("[");
 
+    // a lambda's own ':' would end the bound
     if (expr.lowerBound) {
-        transformExpr(expr.lowerBound);
+        transformOperand(expr.lowerBound, IfLevel);
     }
 
     addText(":");
 
     if (expr.upperBound) {
-        transformExpr(expr.upperBound);
+        transformOperand(expr.upperBound, IfLevel);
     }
 
     addText(":");
 
     if (expr.stride) {
-        transformExpr(expr.stride);
+        transformOperand(expr.stride, IfLevel);
     }
 
     addText("]");
 }
 
-void PythonAstTransformer::transformCallExpr(
+void PythonAstTransformer::visitCallExpr(
     const CallExpr& expr
 ) {
-    transformExpr(expr.primary);
+    transformOperand(expr.primary, PrimaryLevel);
     addText("(");
 
     if (expr.comprehension) {
@@ -452,7 +477,7 @@ void PythonAstTransformer::transformCallExpr(
     while (i < expr.argumentList.size()) {
         transformArgument(expr.argumentList[i]);
         if (i != expr.argumentList.size() - 1) {
-            addText(", ");
+            addText(", ", ",");
         }
         i++;
     }
@@ -460,30 +485,148 @@ void PythonAstTransformer::transformCallExpr(
     addText(")");
 }
 
-void PythonAstTransformer::transformUnaryExpr(
+void PythonAstTransformer::visitUnaryExpr(
     const UnaryExpr& expr
 ) {
     addText(toString(expr.op));
-    addText("(");
-    transformExpr(expr.expr);
-    addText(")");
+
+    if (not minify) {
+        addText("(");
+        transformExpr(expr.expr);
+        addText(")");
+        return;
+    }
+
+    // the parser reads the operand of 'not' as a comparison and that of 
+    // '-', '+' and '~' as a power
+    if (expr.op == TokenKind::ConditionalNot) {
+        if (getPrecedence(*expr.expr) >= ComparisonLevel) {
+            addText(" ");
+        }
+
+        transformOperand(expr.expr, ComparisonLevel);
+        return;
+    }
+
+    transformOperand(expr.expr, PowerLevel);
 }
 
-void PythonAstTransformer::transformBinaryExpr(
+// Left-associative operators build their chains down the left operands, 
+// so that a sum of many thousands of terms is a tree as deep as it is 
+// long. The chain is walked with a stack of its own instead of through 
+// transformExpr, which would use up the thread's stack: every link is 
+// opened on the way down, and given its operator and right operand on 
+// the way back up.
+void PythonAstTransformer::visitBinaryExpr(
     const BinaryExpr& expr
 ) {
-    addText("(");
-    transformExpr(expr.lhs);
-    addText(" ");
+    auto base = binaryChain.size();
+    auto link = &expr;
+
+    binaryChain.push_back({ link, not minify });
+
+    if (not minify) {
+        addText("(");
+    }
+
+    // takes in every left operand that would be generated here anyway, 
+    // rather than copied or given to another visit function; the start of 
+    // a comparison chain always is, since a copy would come bracketed
+    while (
+        (link->lhs->kind == ExprKind::Binary)
+        && not link->lhs->await
+        && (
+            link->continuesChain 
+            || not canCopy(link->lhs->dirty, link->lhs->range)
+        )
+    ) {
+        auto lhs = static_cast<const BinaryExpr*>(link->lhs);
+        bool bracketed = minify 
+            && (getPrecedence(*lhs) < getLeftOperandLevel(*link));
+
+        if (bracketed) {
+            addText("(");
+        }
 
-    addText(toString(expr.op));
+        mapLocation(lhs->location);
 
-    addText(" ");
-    transformExpr(expr.rhs);
-    addText(")");
+        // normal output brackets every link of its own but the start of 
+        // a comparison chain, which shares the brackets of its end
+        if (not minify && not link->continuesChain) {
+            addText("(");
+            bracketed = true;
+        }
+
+        link = lhs;
+        binaryChain.push_back({ link, bracketed });
+    }
+
+    transformOperand(link->lhs, getLeftOperandLevel(*link));
+
+    while (binaryChain.size() > base) {
+        auto [inner, bracketed] = binaryChain.back();
+        binaryChain.pop_back();
+
+        transformBinaryOperator(*inner);
+
+        if (bracketed) {
+            addText(")");
+        }
+    }
+}
+
+// Every binary operator is parsed left-associatively, so only a right 
+// operand of the same level needs parentheses. Comparisons are the first 
+// exception: a<b<c is a chain, so the left operand of one that is not 
+// (as in (a<b)<c) is bracketed if it is a comparison too. '**' is the 
+// other: python groups it from the right, so its left operand is 
+// bracketed unless it is a primary.
+PythonAstTransformer::Precedence PythonAstTransformer::getLeftOperandLevel(
+    const BinaryExpr& expr
+) const {
+    auto precedence = getPrecedence(expr.op);
+
+    if ((precedence == ComparisonLevel) && not expr.continuesChain) {
+        return Precedence(ComparisonLevel + 1);
+    }
+
+    return (precedence == PowerLevel) ? AwaitLevel : precedence;
+}
+
+// the operator and the right operand of an expression whose left operand 
+// has been emitted
+void PythonAstTransformer::transformBinaryOperator(
+    const BinaryExpr& expr
+) {
+    auto op = std::string_view(toString(expr.op));
+
+    if (not minify) {
+        addText(" ");
+        addText(op);
+        addText(" ");
+        transformExpr(expr.rhs);
+        return;
+    }
+
+    // 'and', 'in', 'is not' and the like still need their spaces
+    if (isNameStartCharacter(op.front())) {
+        addText(" ");
+        addText(op);
+        addText(" ");
+    }
+    else {
+        addText(op);
+    }
+
+    // the right operand of '**' may be signed or another power: a**-b**c
+    auto rhsLevel = (expr.op == TokenKind::ArithmeticPow) 
+        ? UnaryLevel 
+        : Precedence(getPrecedence(expr.op) + 1);
+
+    transformOperand(expr.rhs, rhsLevel);
 }
 
-void PythonAstTransformer::transformLambdaExpr(
+void PythonAstTransformer::visitLambdaExpr(
     const LambdaExpr& expr
 ) {
     addText("lambda");
@@ -495,12 +638,12 @@ void PythonAstTransformer::transformLambdaExpr(
         while (i < expr.parameterList.size()) {
             transformParameter(expr.parameterList[i]);
             if (i != expr.parameterList.size() - 1) {
-                addText(", ");
+                addText(", ", ",");
             }
             i++;
         }
     }
 
-    addText(": ");
+    addText(": ", ":");
     transformExpr(expr.expr);
 }
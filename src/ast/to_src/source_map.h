@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief      Maps offsets in the transformer's output back to the
+ *             locations of the nodes emitted there, so that a traceback
+ *             through transformed code can be pointed at the original
+ *             source.
+ *
+ * The map is written as text:
+ *
+ *     petmap 1
+ *     <file id> <file name>      (one line for every file mapped to)
+ *     mappings
+ *     <mapping>,<mapping>,...
+ *
+ * Each mapping is four base64 VLQ numbers, as in javascript source maps:
+ * the change from the previous mapping (or from 0) in output offset, file
+ * id, line and column. Lines and columns count from 1; columns count bytes.
+ */
+class SourceMap {
+public:
+    struct Mapping {
+        uint64_t outputOffset;
+        Location location;
+    };
+
+    /**
+     * @brief      Records that the output from 'outputOffset' on comes from
+     *             'location'. Offsets must not decrease from one call to
+     *             the next. A location without a file, one equal to the
+     *             last one recorded, or a second one at the same offset
+     *             adds nothing.
+     *
+     * @param[in]  outputOffset  The offset in the output.
+     * @param[in]  location      The location in the source.
+     */
+    void addMapping(uint64_t outputOffset, const Location& location) {
+        if (location.fileId == 0) {
+            return;
+        }
+
+        if (not mappings.empty()) {
+            auto& last = mappings.back();
+
+            if (
+                (last.outputOffset == outputOffset)
+                || (
+                    (last.location.fileId == location.fileId)
+                    && (last.location.offset == location.offset)
+                )
+            ) {
+                return;
+            }
+        }
+
+        mappings.push_back({ outputOffset, location });
+    }
+
+    // adds the mappings of a map made for output that starts at 
+    // 'outputOffset' of this one
+    void append(const SourceMap& other, uint64_t outputOffset) {
+        for (auto& mapping : other.mappings) {
+            addMapping(outputOffset + mapping.outputOffset, mapping.location);
+        }
+    }
+
+    const std::vector<Mapping>& getMappings() const {
+        return mappings;
+    }
+
+    void clear() {
+        mappings.clear();
+    }
+
+    // writes the map in the form described above
+    void write(OutputSink& sink) const {
+        std::string text = "petmap 1\n";
+        std::vector<uint32_t> fileIds;
+
+        for (auto& mapping : mappings) {
+            auto id = mapping.location.fileId;
+
+            if (std::find(fileIds.begin(), fileIds.end(), id) == fileIds.end()) {
+                fileIds.push_back(id);
+                text += std::to_string(id);
+                text += ' ';
+                text += getSourceManager().getFileName(id);
+                text += '\n';
+            }
+        }
+
+        text += "mappings\n";
+
+        int64_t lastOffset = 0;
+        int64_t lastFileId = 0;
+        int64_t lastLine = 0;
+        int64_t lastColumn = 0;
+
+        for (size_t i = 0; i < mappings.size(); ++i) {
+            auto& mapping = mappings[i];
+            auto resolved = getSourceManager().resolve(mapping.location);
+
+            int64_t offset = mapping.outputOffset;
+            int64_t fileId = mapping.location.fileId;
+            int64_t line = resolved.line;
+            int64_t column = resolved.column;
+
+            if (i != 0) {
+                text += ',';
+            }
+
+            appendVlq(text, offset - lastOffset);
+            appendVlq(text, fileId - lastFileId);
+            appendVlq(text, line - lastLine);
+            appendVlq(text, column - lastColumn);
+
+            lastOffset = offset;
+            lastFileId = fileId;
+            lastLine = line;
+            lastColumn = column;
+        }
+
+        text += '\n';
+        sink.write(text);
+    }
+
+private:
+    // the sign goes in the lowest bit, then 5 bits per digit, lowest
+    // first, with 0x20 set on every digit but the last
+    static void appendVlq(std::string& out, int64_t value) {
+        static constexpr std::string_view digits =
+            "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+        uint64_t bits = (value < 0)
+            ? (uint64_t(-value) << 1) | 1
+            : uint64_t(value) << 1;
+
+        do {
+            uint64_t digit = bits & 0x1f;
+            bits >>= 5;
+
+            if (bits != 0) {
+                digit |= 0x20;
+            }
+
+            out += digits[digit];
+        } while (bits != 0);
+    }
+
+    std::vector<Mapping> mappings;
+};
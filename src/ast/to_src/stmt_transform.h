@@ -1,217 +1,269 @@
 #pragma once
 
 void PythonAstTransformer::transformStmt(StmtPtr stmt, int indent) {
-    if (indent != 0) {
-        addText(std::string(indent, ' '));
+    if (minify) {
+        transformMinifiedStmt(stmt, indent);
+        return;
     }
 
-    switch (stmt->kind) {
-    case StmtKind::None: return;
-    case StmtKind::Expression: {
-        transformExpr(std::static_pointer_cast<ExprStmt>(stmt)->expr);
-        break;
-    }
-    case StmtKind::Assert: {
-        transformAssertStmt(
-            *std::static_pointer_cast<AssertStmt>(stmt)
-        );
-        break;
-    }
-    case StmtKind::Assignment: {
-        transformAssignmentStmt(
-            *std::static_pointer_cast<AssignmentStmt>(stmt)
-        );
-        break;
-    }
-    case StmtKind::AugmentedAssignment: {
-        transformAugmentedAssignmentStmt(
-            *std::static_pointer_cast<AugmentedAssignmentStmt>(stmt)
-        );
-        break;
-    }
-    case StmtKind::AnnotatedAssignment: {
-        transformAnnotatedAssignmentStmt(
-            *std::static_pointer_cast<AnnotatedAssignmentStmt>(stmt)
-        );
-        break;
-    }
-    case StmtKind::Pass: {
-        addText("pass");
-        break;
-    }
-    case StmtKind::Del: {
-        transformDelStmt(
-            *std::static_pointer_cast<DelStmt>(stmt)
-        );
-        break;
-    }
-    case StmtKind::Return: {
-        transformReturnStmt(
-            *std::static_pointer_cast<ReturnStmt>(stmt)
-        );
-        break;
+    addIndent(indent);
+    mapLocation(stmt->location);
+
+    if (copyOriginal(*stmt, indent)) {
+        addNewLine();
+        return;
     }
-    case StmtKind::Yield: {
-        transformYieldStmt(
-            *std::static_pointer_cast<YieldStmt>(stmt)
-        );
-        break;
+
+    visitStmt(*stmt, indent);
+
+    // compound statements end with their suites' newlines
+    if ((stmt->kind != StmtKind::None) && not isCompoundStmt(stmt->kind)) {
+        addNewLine();
     }
-    case StmtKind::Raise: {
-        transformRaiseStmt(
-            *std::static_pointer_cast<RaiseStmt>(stmt)
-        );
-        break;
+}
+
+// A simple statement leaves its line open, and the next one joins it with 
+// ';' if it belongs to the same suite, which is the case exactly when it 
+// comes at the same indentation without anything in between.
+void PythonAstTransformer::transformMinifiedStmt(StmtPtr stmt, int indent) {
+    if (stmt->kind == StmtKind::None) {
+        closeLine();
+        return;
     }
-    case StmtKind::Break: {
-        addText("break");
-        break;
+
+    bool isSimple = not isCompoundStmt(stmt->kind);
+
+    if (isSimple and openLineIndent == indent) {
+        addText(";");
     }
-    case StmtKind::Continue: {
-        addText("continue");
-        break;
+    else {
+        startLine(indent);
     }
-    case StmtKind::Import: {
-        transformImportStmt(
-            *std::static_pointer_cast<ImportStmt>(stmt)
-        );
-        break;
+
+    mapLocation(stmt->location);
+    visitStmt(*stmt, indent);
+
+    if (isSimple) {
+        openLineIndent = indent;
     }
-    case StmtKind::Global: {
-        transformGlobalStmt(
-            *std::static_pointer_cast<GlobalStmt>(stmt)
-        );
-        break;
+}
+
+// A statement over several lines, such as any compound statement, keeps 
+// its later lines as they were, which is only right if its first line was 
+// at the indentation it is being emitted at.
+bool PythonAstTransformer::canCopyStmt(const Stmt& stmt, int indent) const {
+    if (not canCopy(stmt.dirty, stmt.range)) {
+        return false;
     }
-    case StmtKind::Nonlocal: {
-        transformNonlocalStmt(
-            *std::static_pointer_cast<NonlocalStmt>(stmt)
-        );
-        break;
+
+    auto text = originalSource.substr(
+        stmt.range.begin, 
+        stmt.range.end - stmt.range.begin
+    );
+
+    return (text.find('\n') == std::string_view::npos)
+        || (getOriginalIndent(stmt.range.begin) == indent);
+}
+
+bool PythonAstTransformer::copyOriginal(const Stmt& stmt, int indent) {
+    if (not canCopyStmt(stmt, indent)) {
+        return false;
     }
-    case StmtKind::If: {
-        transformIfStmt(
-            *std::static_pointer_cast<IfStmt>(stmt),
-            indent
+
+    addText(originalSource.substr(
+        stmt.range.begin, 
+        stmt.range.end - stmt.range.begin
+    ));
+
+    // and the comment at the end of its line, if nothing else follows it
+    auto lineEnd = findQuietLineEnd(stmt.range.end);
+
+    if (lineEnd != std::string_view::npos) {
+        auto rest = originalSource.substr(
+            stmt.range.end, 
+            lineEnd - stmt.range.end
         );
-        return;
+
+        if (rest.find('#') != std::string_view::npos) {
+            while (isspace(static_cast<unsigned char>(rest.back()))) {
+                rest.remove_suffix(1);
+            }
+            addText(rest);
+        }
     }
-    case StmtKind::While: {
-        transformWhileStmt(
-            *std::static_pointer_cast<WhileStmt>(stmt),
-            indent
-        );
-        return;
+
+    return true;
+}
+
+// Copies the lines between two statements of a suite that are both copied, 
+// and that are on lines of their own, so that the comments and blank lines 
+// there are kept. Called at the start of the line of 'stmt', before it is 
+// indented.
+bool PythonAstTransformer::copyGap(
+    const Stmt& previous, 
+    const Stmt& stmt, 
+    int indent
+) {
+    if (
+        not canCopyStmt(previous, indent) 
+        || not canCopyStmt(stmt, indent)
+        || (getOriginalIndent(stmt.range.begin) != indent)
+    ) {
+        return false;
     }
-    case StmtKind::For: {
-        transformForStmt(
-            *std::static_pointer_cast<ForStmt>(stmt),
-            indent
-        );
-        return;
+
+    auto lineEnd = findQuietLineEnd(previous.range.end);
+    size_t lineStart = stmt.range.begin - indent;
+
+    if ((lineEnd == std::string_view::npos) || (lineEnd >= lineStart)) {
+        return false;
     }
-    case StmtKind::Try: {
-        transformTryStmt(
-            *std::static_pointer_cast<TryStmt>(stmt),
-            indent
-        );
-        return;
+
+    addText(originalSource.substr(lineEnd + 1, lineStart - lineEnd - 1));
+    return true;
+}
+
+// the offset of the '\n' that ends the line 'offset' is on (or of the end 
+// of the source) if only spaces, ';'s and a comment follow 'offset' on it; 
+// npos if anything else does
+size_t PythonAstTransformer::findQuietLineEnd(uint32_t offset) const {
+    size_t position = offset;
+
+    while (
+        (position < originalSource.size()) 
+        && (
+            (originalSource[position] == ';') 
+            || (
+                (originalSource[position] != '\n') 
+                && isspace(static_cast<unsigned char>(originalSource[position]))
+            )
+        )
+    ) {
+        position++;
     }
-    case StmtKind::With: {
-        transformWithStmt(
-            *std::static_pointer_cast<WithStmt>(stmt),
-            indent
-        );
-        return;
+
+    if ((position < originalSource.size()) && (originalSource[position] == '#')) {
+        position = originalSource.find('\n', position);
+        return (position == std::string_view::npos) 
+            ? originalSource.size() 
+            : position;
     }
-    case StmtKind::Funcdef: {
-        transformFuncdefStmt(
-            *std::static_pointer_cast<FuncdefStmt>(stmt),
-            indent
-        );
-        return;
+
+    if ((position == originalSource.size()) || (originalSource[position] == '\n')) {
+        return position;
     }
-    case StmtKind::Classdef: {
-        transformClassdefStmt(
-            *std::static_pointer_cast<ClassdefStmt>(stmt),
-            indent
-        );
-        return;
+
+    return std::string_view::npos;
+}
+
+// how many spaces come before 'offset' on its line; -1 if anything else does
+int PythonAstTransformer::getOriginalIndent(uint32_t offset) const {
+    auto lineStart = offset;
+
+    while ((lineStart > 0) && (originalSource[lineStart - 1] == ' ')) {
+        lineStart--;
     }
-    default:
-        assert(0);
+
+    if ((lineStart > 0) && (originalSource[lineStart - 1] != '\n')) {
+        return -1;
     }
-    addNewLine();
+
+    return offset - lineStart;
+}
+
+void PythonAstTransformer::visitNoneStmt(const Stmt&, int) {}
+
+void PythonAstTransformer::visitExpressionStmt(const ExprStmt& stmt, int) {
+    transformExpr(stmt.expr);
 }
 
-void PythonAstTransformer::transformAssertStmt(const AssertStmt& stmt) {
+void PythonAstTransformer::visitPassStmt(const Stmt&, int) {
+    addText("pass");
+}
+
+void PythonAstTransformer::visitBreakStmt(const Stmt&, int) {
+    addText("break");
+}
+
+void PythonAstTransformer::visitContinueStmt(const Stmt&, int) {
+    addText("continue");
+}
+
+void PythonAstTransformer::visitErrorStmt(const ErrorStmt& stmt, int) {
+    addText(stmt.text);
+}
+
+void PythonAstTransformer::visitAssertStmt(const AssertStmt& stmt, int) {
     addText("assert ");
     transformExpr(stmt.expr1);
 
     if (stmt.expr2) {
-        addText(", ");
+        addText(", ", ",");
         transformExpr(stmt.expr2);
     }
 }
 
-void PythonAstTransformer::transformAssignmentStmt(
-    const AssignmentStmt& stmt
+void PythonAstTransformer::visitAssignmentStmt(
+    const AssignmentStmt& stmt,
+    int
 ) {
     int i = 0;
 
     while (i < stmt.targetList.size()) {
         transformExpr(stmt.targetList[i]);
         if (i != stmt.targetList.size() - 1) {
-            addText(", ");
+            addText(", ", ",");
         }
         i++;
     }
 
-    addText(" = ");
+    addText(" = ", "=");
 
     transformExpr(stmt.value);
 }
 
-void PythonAstTransformer::transformAugmentedAssignmentStmt(
-    const AugmentedAssignmentStmt& stmt
+void PythonAstTransformer::visitAugmentedAssignmentStmt(
+    const AugmentedAssignmentStmt& stmt,
+    int
 ) {
     transformExpr(stmt.autoTarget);
 
-    addText(" ");
+    addText(" ", "");
     addText(toString(stmt.augOp));
-    addText(" ");
+    addText(" ", "");
 
     int i = 0;
 
     while (i < stmt.values.size()) {
         transformExpr(stmt.values[i]);
         if (i != stmt.values.size() - 1) {
-            addText(", ");
+            addText(", ", ",");
         }
         i++;
     }
 }
 
-void PythonAstTransformer::transformAnnotatedAssignmentStmt(
-    const AnnotatedAssignmentStmt& stmt
+void PythonAstTransformer::visitAnnotatedAssignmentStmt(
+    const AnnotatedAssignmentStmt& stmt,
+    int
 ) {
     transformExpr(stmt.autoTarget);
-    addText(": ");
+    addText(": ", ":");
     transformExpr(stmt.annotation);
-    addText(" = ");
+    addText(" = ", "=");
     transformExpr(stmt.value);
 }
 
 void PythonAstTransformer::transformTarget(const TargetPtr target) {
     if (target->kind == TargetKind::Expr) {
-        auto exprTarget = std::static_pointer_cast<ExprTarget>(target);
+        auto exprTarget = static_cast<ExprTarget*>(target);
         for(int i = 0; i < exprTarget->stars; ++i) {
             addText("*");
         }
         transformExpr(exprTarget->expr);
     }
     else {
-        auto newTarget = std::static_pointer_cast<BrackettedTarget>(target);
+        auto newTarget = static_cast<BrackettedTarget*>(target);
         if (newTarget->bracketKind == TokenKind::OpeningRoundBracket) {
             addText("(");
         }
@@ -224,7 +276,7 @@ void PythonAstTransformer::transformTarget(const TargetPtr target) {
         while (i < newTarget->targets.size()) {
             transformTarget(newTarget->targets[i]);
             if (i != newTarget->targets.size() - 1) {
-                addText(", ");
+                addText(", ", ",");
             }
             i++;
         }
@@ -238,48 +290,56 @@ void PythonAstTransformer::transformTarget(const TargetPtr target) {
     }
 }
 
-void PythonAstTransformer::transformDelStmt(const DelStmt& stmt) {
+void PythonAstTransformer::visitDelStmt(const DelStmt& stmt, int) {
     addText("del ");
     int i = 0;
 
     while (i < stmt.targetList.size()) {
         transformTarget(stmt.targetList[i]);
         if (i != stmt.targetList.size() - 1) {
-            addText(", ");
+            addText(", ", ",");
         }
         i++;
     }
 }
 
-void PythonAstTransformer::transformReturnStmt(const ReturnStmt& stmt) {
-    addText("return ");
+void PythonAstTransformer::visitReturnStmt(const ReturnStmt& stmt, int) {
+    addText("return ", "return");
 
     if (stmt.exprList.size() == 0) {
         return;
     }
 
+    if (minify) {
+        addText(" ");
+    }
+
     int i = 0;
 
     while (i < stmt.exprList.size()) {
         transformExpr(stmt.exprList[i]);
         if (i != stmt.exprList.size() - 1) {
-            addText(", ");
+            addText(", ", ",");
         }
         i++;
     }
 }
 
-void PythonAstTransformer::transformYieldStmt(const YieldStmt& stmt) {
+void PythonAstTransformer::visitYieldStmt(const YieldStmt& stmt, int) {
     transformExpr(stmt.expr);
 }
 
-void PythonAstTransformer::transformRaiseStmt(const RaiseStmt& stmt) {
-    addText("raise ");
+void PythonAstTransformer::visitRaiseStmt(const RaiseStmt& stmt, int) {
+    addText("raise ", "raise");
 
     if (not stmt.expr) {
         return;
     }
 
+    if (minify) {
+        addText(" ");
+    }
+
     transformExpr(stmt.expr);
 
     if (stmt.fromExpr) {
@@ -312,7 +372,7 @@ void PythonAstTransformer::transformImportItem(const ImportItem& item) {
     }
 }
 
-void PythonAstTransformer::transformImportStmt(const ImportStmt& stmt) {
+void PythonAstTransformer::visitImportStmt(const ImportStmt& stmt, int) {
     if (stmt.source.size() > 0) {
         addText("from ");
 
@@ -333,7 +393,7 @@ void PythonAstTransformer::transformImportStmt(const ImportStmt& stmt) {
         while (i < stmt.items.size()) {
             transformImportItem(stmt.items[i]);
             if (i != stmt.items.size() - 1) {
-                addText(", ");
+                addText(", ", ",");
             }
             i++;
         }
@@ -346,14 +406,14 @@ void PythonAstTransformer::transformImportStmt(const ImportStmt& stmt) {
         while (i < stmt.items.size()) {
             transformImportItem(stmt.items[i]);
             if (i != stmt.items.size() - 1) {
-                addText(", ");
+                addText(", ", ",");
             }
             i++;
         }
     }
 }
 
-void PythonAstTransformer::transformGlobalStmt(const GlobalStmt& stmt) {
+void PythonAstTransformer::visitGlobalStmt(const GlobalStmt& stmt, int) {
     addText("global ");
 
     int i = 0;
@@ -361,13 +421,13 @@ void PythonAstTransformer::transformGlobalStmt(const GlobalStmt& stmt) {
     while (i < stmt.names.size()) {
         addText(stmt.names[i]);
         if (i != stmt.names.size() - 1) {
-            addText(", ");
+            addText(", ", ",");
         }
         i++;
     }
 }
 
-void PythonAstTransformer::transformNonlocalStmt(const NonlocalStmt& stmt) {
+void PythonAstTransformer::visitNonlocalStmt(const NonlocalStmt& stmt, int) {
     addText("nonlocal ");
 
     int i = 0;
@@ -375,13 +435,13 @@ void PythonAstTransformer::transformNonlocalStmt(const NonlocalStmt& stmt) {
     while (i < stmt.names.size()) {
         addText(stmt.names[i]);
         if (i != stmt.names.size() - 1) {
-            addText(", ");
+            addText(", ", ",");
         }
         i++;
     }
 }
 
-void PythonAstTransformer::transformIfStmt(
+void PythonAstTransformer::visitIfStmt(
     const IfStmt& stmt, 
     int indent
 ) {
@@ -391,7 +451,7 @@ void PythonAstTransformer::transformIfStmt(
 
     auto it = std::begin(stmt.suites) + 1;
     while (it != std::end(stmt.suites)) {
-        addIndent(indent);
+        startLine(indent);
         addText("elif ");
         transformExpr(it->first);
         transformSuite(it->second, indent);                
@@ -399,13 +459,13 @@ void PythonAstTransformer::transformIfStmt(
     }
 
     if (stmt.elseSuite.stmts.size() > 0) {
-        addIndent(indent);
+        startLine(indent);
         addText("else");
         transformSuite(stmt.elseSuite, indent);
     }
 }
 
-void PythonAstTransformer::transformWhileStmt(
+void PythonAstTransformer::visitWhileStmt(
     const WhileStmt& stmt, 
     int indent
 ) {
@@ -414,13 +474,13 @@ void PythonAstTransformer::transformWhileStmt(
     transformSuite(stmt.suite, indent);
 
     if (stmt.elseSuite.stmts.size() > 0) {
-        addIndent(indent);
+        startLine(indent);
         addText("else");
         transformSuite(stmt.elseSuite, indent);
     }
 }
 
-void PythonAstTransformer::transformForStmt(
+void PythonAstTransformer::visitForStmt(
     const ForStmt& stmt, 
     int indent
 ) {
@@ -436,7 +496,7 @@ void PythonAstTransformer::transformForStmt(
     while (i < stmt.targetList.size()) {
         addText(stmt.targetList[i]);
         if (i != stmt.targetList.size() - 1) {
-            addText(", ");
+            addText(", ", ",");
         }
         i++;
     }
@@ -448,7 +508,7 @@ void PythonAstTransformer::transformForStmt(
     while (i < stmt.exprList.size()) {
         transformExpr(stmt.exprList[i]);
         if (i != stmt.exprList.size() - 1) {
-            addText(", ");
+            addText(", ", ",");
         }
         i++;
     }
@@ -456,7 +516,7 @@ void PythonAstTransformer::transformForStmt(
     transformSuite(stmt.suite, indent);
 
     if (stmt.elseSuite.stmts.size() > 0) {
-        addIndent(indent);
+        startLine(indent);
         addText("else");
         transformSuite(stmt.elseSuite, indent);
     }
@@ -466,7 +526,7 @@ void PythonAstTransformer::transformExcept(
     const TryExcept& except, 
     int indent
 ) {
-    addIndent(indent);
+    startLine(indent);
     addText("except");
 
     if (except.expr) {
@@ -482,7 +542,7 @@ void PythonAstTransformer::transformExcept(
     transformSuite(except.suite, indent);
 }
 
-void PythonAstTransformer::transformTryStmt(
+void PythonAstTransformer::visitTryStmt(
     const TryStmt& stmt, 
     int indent
 ) {
@@ -494,13 +554,13 @@ void PythonAstTransformer::transformTryStmt(
     }
 
     if (stmt.elseSuite.stmts.size() > 0) {
-        addIndent(indent);
+        startLine(indent);
         addText("else");
         transformSuite(stmt.elseSuite, indent);
     }
 
     if (stmt.finallySuite.stmts.size() > 0) {
-        addIndent(indent);
+        startLine(indent);
         addText("finally");
         transformSuite(stmt.finallySuite, indent);
     }
@@ -515,7 +575,7 @@ void PythonAstTransformer::transformWithItem(const WithItem& item) {
     }
 }
 
-void PythonAstTransformer::transformWithStmt(
+void PythonAstTransformer::visitWithStmt(
     const WithStmt& stmt, 
     int indent
 ) {
@@ -530,7 +590,7 @@ void PythonAstTransformer::transformWithStmt(
     while (i < stmt.items.size()) {
         transformWithItem(stmt.items[i]);
         if (i != stmt.items.size() - 1) {
-            addText(", ");
+            addText(", ", ",");
         }
         i++;
     }
@@ -561,7 +621,7 @@ void PythonAstTransformer::transformDecorator(const Decorator& decorator) {
     while (i < decorator.argumentList.size()) {
         transformArgument(decorator.argumentList[i]);
         if (i != decorator.argumentList.size() - 1) {
-            addText(", ");
+            addText(", ", ",");
         }
         i++;
     }
@@ -577,7 +637,7 @@ void PythonAstTransformer::transformParameter(const Parameter& parameter) {
     addText(parameter.name);
     
     if (parameter.hint) {
-        addText(": ");
+        addText(": ", ":");
         transformExpr(parameter.hint);
     }
 
@@ -587,7 +647,7 @@ void PythonAstTransformer::transformParameter(const Parameter& parameter) {
     }
 }
 
-void PythonAstTransformer::transformFuncdefStmt(
+void PythonAstTransformer::visitFuncdefStmt(
     const FuncdefStmt& stmt, 
     int indent
 ) {
@@ -608,7 +668,7 @@ void PythonAstTransformer::transformFuncdefStmt(
     while (i < stmt.parameterList.size()) {
         transformParameter(stmt.parameterList[i]);
         if (i != stmt.parameterList.size() - 1) {
-            addText(", ");
+            addText(", ", ",");
         }
         i++;
     }
@@ -616,14 +676,14 @@ void PythonAstTransformer::transformFuncdefStmt(
     addText(")");
 
     if (stmt.hint) {
-        addText(" -> ");
+        addText(" -> ", "->");
         transformExpr(stmt.hint);
     }
 
-    transformSuite(stmt.suite, indent);
+    transformSuite(stmt.getSuite(), indent);
 }
 
-void PythonAstTransformer::transformClassdefStmt(
+void PythonAstTransformer::visitClassdefStmt(
     const ClassdefStmt& stmt, 
     int indent
 ) {
@@ -633,7 +693,14 @@ void PythonAstTransformer::transformClassdefStmt(
     }
 
     addText("class ");
-    addText(stmt.name + "(");
+    addText(stmt.name);
+
+    if (minify and stmt.argumentList.size() == 0) {
+        transformSuite(stmt.suite, indent);
+        return;
+    }
+
+    addText("(");
 
     if (stmt.argumentList.size() == 0) {
         addText("object");
@@ -644,7 +711,7 @@ void PythonAstTransformer::transformClassdefStmt(
         while (i < stmt.argumentList.size()) {
             transformArgument(stmt.argumentList[i]);
             if (i != stmt.argumentList.size() - 1) {
-                addText(", ");
+                addText(", ", ",");
             }
             i++;
         }
@@ -659,33 +726,27 @@ void PythonAstTransformer::transformSuite(const Suite& suite, int indent) {
     addNewLine();
 
     if (suite.stmts.size() > 0) {
-        int i = 0;
-
-        while (i < suite.stmts.size()) {
-            transformStmt(suite.stmts[i], indent + 4);
-
-            if (i != suite.stmts.size() - 1) {
-                switch (suite.stmts[i]->kind) {
-                case StmtKind::If:
-                case StmtKind::While:
-                case StmtKind::For:
-                case StmtKind::Try:
-                case StmtKind::With:
-                case StmtKind::Funcdef:
-                case StmtKind::Classdef: {
+        auto stmtIndent = indent + getIndentStep();
+
+        for (size_t i = 0; i < suite.stmts.size(); ++i) {
+            if ((i != 0) && not minify) {
+                auto& previous = *suite.stmts[i - 1];
+
+                // a compound statement is followed by a blank line, unless 
+                // the lines that came after it are copied instead
+                if (
+                    not copyGap(previous, *suite.stmts[i], stmtIndent) 
+                    && isCompoundStmt(previous.kind)
+                ) {
                     addNewLine();
-                    break;
-                }
-                default:
-                    assert(1);
                 }
             }
-            i++;
+
+            transformStmt(suite.stmts[i], stmtIndent);
         }
     }
     else {
-        Location location;
-        auto tempStmt = std::make_shared<Stmt>(location, StmtKind::Pass);
-        transformStmt(tempStmt, indent + 4);
+        Stmt passStmt(Location(), StmtKind::Pass);
+        transformStmt(&passStmt, indent + getIndentStep());
     }
 }
@@ -1,40 +1,191 @@
 #pragma once
-#include <regex>
+#include "escape.h"
+#include "source_map.h"
+#include "dirtiness.h"
 
-class PythonAstTransformer {
+class PythonAstTransformer : public AstVisitor<PythonAstTransformer> {
 public:
     void appendStmt(StmtPtr stmt) {
-        switch (stmt->kind) {
-        case StmtKind::If:
-        case StmtKind::While:
-        case StmtKind::For:
-        case StmtKind::Try:
-        case StmtKind::With:
-        case StmtKind::Funcdef:
-        case StmtKind::Classdef: {
-            addNewLine();
+        if (minify) {
             transformStmt(stmt, 0);
-            nextGlobalStmtShouldBeOnANewLine = true;
-            break;
+            return;
         }
-        default:
-            if (nextGlobalStmtShouldBeOnANewLine) {
+
+        // the lines copied in between take the place of the blank ones
+        bool gapCopied = previousGlobalStmt 
+            && copyGap(*previousGlobalStmt, *stmt, 0);
+        previousGlobalStmt = stmt;
+
+        if (isCompoundStmt(stmt->kind)) {
+            if (not gapCopied) {
                 addNewLine();
-                nextGlobalStmtShouldBeOnANewLine = false;
             }
             transformStmt(stmt, 0);
+            nextGlobalStmtShouldBeOnANewLine = true;
+            return;
+        }
+
+        if (nextGlobalStmtShouldBeOnANewLine) {
+            if (not gapCopied) {
+                addNewLine();
+            }
+            nextGlobalStmtShouldBeOnANewLine = false;
         }
+        transformStmt(stmt, 0);
     }
 
+    // with an output sink set, this only holds what has not been sent yet
     const std::string& getBuffer() {
         return buffer;
     }
 
     void clearBuffer() {
+        sentBytes += buffer.size();
         buffer.clear();
     }
 
+    // hands over what is buffered and empties the buffer
+    std::string takeBuffer() {
+        std::string output;
+        output.swap(buffer);
+        sentBytes += output.size();
+        return output;
+    }
+
+    /**
+     * @brief      Carries on as if 'previous' had been the last top-level 
+     *  statement appended, so that a module can be transformed in pieces 
+     *  and the pieces joined. The spacing before a top-level statement only 
+     *  depends on the kind of the one before it.
+     *
+     * @param[in]  previous  The statement before the first one to append.
+     */
+    void continueAfter(StmtPtr previous) {
+        if (not minify) {
+            nextGlobalStmtShouldBeOnANewLine = isCompoundStmt(previous->kind);
+            previousGlobalStmt = previous;
+            return;
+        }
+
+        // a compound statement ends with an open line inside its suite
+        if (previous->kind == StmtKind::None) {
+            openLineIndent = -1;
+        }
+        else {
+            openLineIndent = isCompoundStmt(previous->kind) 
+                ? getIndentStep() 
+                : 0;
+        }
+    }
+
+    /**
+     * @brief      Sends the output to a sink as it is produced, in chunks 
+     *  of 'chunkSize' bytes, so that no more than about one chunk is held 
+     *  at a time. Call flush() after the last statement.
+     *
+     * @param      sink       The sink; it must outlive the transformer.
+     * @param[in]  chunkSize  The chunk size.
+     */
+    void setOutputSink(OutputSink* sink, size_t chunkSize = 64 * 1024) {
+        this->sink = sink;
+        this->chunkSize = chunkSize;
+        buffer.reserve(chunkSize * 2);
+    }
+
+    /**
+     * @brief      Makes room in the buffer for the output of a module of 
+     *  'sourceBytes' bytes, so that it is not grown over and over again as 
+     *  the module is emitted. With an output sink set, the buffer never 
+     *  holds more than about two chunks, and this does nothing.
+     *
+     * @param[in]  sourceBytes  The size of the source the statements to 
+     *  come were parsed from.
+     */
+    void reserveForSource(size_t sourceBytes) {
+        if (sink) {
+            return;
+        }
+
+        // Comments and blank lines that are dropped make up for most of 
+        // the spaces that are added, so the output comes out about as 
+        // long as the source.
+        buffer.reserve(buffer.size() + sourceBytes + sourceBytes / 8);
+    }
+
+    /**
+     * @brief      Emits the smallest source that means the same thing: 
+     *  1-space indents, no optional whitespace or parentheses, no blank 
+     *  lines, and consecutive simple statements joined with ';'. Set it 
+     *  before the first statement.
+     */
+    void enableMinifiedOutput() {
+        minify = true;
+    }
+
+    /**
+     * @brief      Copies the source of every statement and expression that 
+     *  is not dirty instead of generating it again, which is faster and 
+     *  keeps the original formatting. A copied statement keeps the comment 
+     *  at the end of its line, and the comments and blank lines between 
+     *  two copied statements of the same suite are copied too; other 
+     *  comments are dropped, as they are without this. Run 
+     *  propagateDirtiness() over the statements first. Minified output 
+     *  ignores this.
+     *
+     * @param[in]  source  The text the statements were parsed from; it must 
+     *  outlive the transformer.
+     */
+    void setOriginalSource(std::string_view source) {
+        originalSource = source;
+    }
+
+    // Records where every statement and expression emitted from now on 
+    // came from. The map must outlive the transformer.
+    void setSourceMap(SourceMap* sourceMap) {
+        this->sourceMap = sourceMap;
+    }
+
+    // sends whatever is buffered to the sink, however much it is
+    void flush() {
+        closeLine();
+
+        if (sink) {
+            sink->write(buffer);
+            sentBytes += buffer.size();
+            buffer.clear();
+        }
+    }
+
 private:
+    friend class AstVisitor<PythonAstTransformer>;
+
+    // How tightly each kind of expression binds, loosest first, following 
+    // the parser's grammar levels. In minified output an operand that binds 
+    // more loosely than its position allows gets parentheses.
+    enum Precedence {
+        YieldLevel,
+        LambdaLevel,
+        IfLevel,
+        OrLevel,
+        AndLevel,
+        NotLevel,
+        ComparisonLevel,
+        BitwiseOrLevel,
+        BitwiseXorLevel,
+        BitwiseAndLevel,
+        ShiftLevel,
+        AdditiveLevel,
+        MultiplicativeLevel,
+        UnaryLevel,
+        PowerLevel,
+        AwaitLevel,
+        PrimaryLevel,
+    };
+
+    static Precedence getPrecedence(const Expr&);
+    static Precedence getPrecedence(TokenKind);
+    void transformOperand(ExprPtr, Precedence);
+
     void transformArgument(const Argument&);
     void transformParameter(const Parameter&);
     void transformWithItem(const WithItem&);
@@ -45,55 +196,96 @@ private:
     void transformComprehensionIter(const CompIter&);
     void transformDictItem(const DictItem&);
 
+    bool canCopy(bool dirty, const SourceRange&) const;
+    bool copyOriginal(const Expr&);
+    bool canCopyStmt(const Stmt&, int) const;
+    bool copyOriginal(const Stmt&, int);
+    bool copyGap(const Stmt&, const Stmt&, int);
+    size_t findQuietLineEnd(uint32_t) const;
+    int getOriginalIndent(uint32_t) const;
+
     void transformExpr(ExprPtr); //remember "await"
-    void transformNameExpr(const NameExpr&);
-    void transformStringLiteralExpr(const StringLiteralExpr&);
-    void transformIntegerLiteralExpr(const IntegerLiteralExpr&);
-    void transformBooleanLiteralExpr(const BooleanLiteralExpr&);
-    void transformFloatLiteralExpr(const FloatLiteralExpr&);
-    void transformListDisplayExpr(const ListDisplayExpr&);
-    void transformTupleDisplayExpr(const TupleDisplayExpr&);
-    void transformDictDisplayExpr(const DictDisplayExpr&);
-    void transformSetDisplayExpr(const SetDisplayExpr&);
-    void transformGeneratorExpr(const GeneratorExpr&);
-    void transformYieldExpr(const YieldExpr&);
-    void transformAttributeRefExpr(const AttributeRefExpr&);
-    void transformSubscriptionExpr(const SubscriptionExpr&);
-    void transformSlicingExpr(const SlicingExpr&);
-    void transformCallExpr(const CallExpr&);
-    void transformUnaryExpr(const UnaryExpr&);
-    void transformBinaryExpr(const BinaryExpr&);
-    void transformLambdaExpr(const LambdaExpr&);
-    void transformIfExpr(const IfExpr&);
+    void visitNoneExpr(const Expr&);
+    void visitAwaitExpr(const AwaitExpr&);
+    void visitNameExpr(const NameExpr&);
+    void visitStringLiteralExpr(const StringLiteralExpr&);
+    void visitIntegerLiteralExpr(const IntegerLiteralExpr&);
+    void visitBooleanLiteralExpr(const BooleanLiteralExpr&);
+    void visitFloatLiteralExpr(const FloatLiteralExpr&);
+    void visitListDisplayExpr(const ListDisplayExpr&);
+    void visitTupleDisplayExpr(const TupleDisplayExpr&);
+    void visitDictDisplayExpr(const DictDisplayExpr&);
+    void visitSetDisplayExpr(const SetDisplayExpr&);
+    void visitGeneratorExpr(const GeneratorExpr&);
+    void visitYieldExpr(const YieldExpr&);
+    void visitAttributeRefExpr(const AttributeRefExpr&);
+    void visitSubscriptionExpr(const SubscriptionExpr&);
+    void visitSlicingExpr(const SlicingExpr&);
+    void visitCallExpr(const CallExpr&);
+    void visitUnaryExpr(const UnaryExpr&);
+    void visitBinaryExpr(const BinaryExpr&);
+    Precedence getLeftOperandLevel(const BinaryExpr&) const;
+    void transformBinaryOperator(const BinaryExpr&);
+    void visitLambdaExpr(const LambdaExpr&);
+    void visitIfExpr(const IfExpr&);
 
     void transformTarget(const TargetPtr);
     void transformImportItem(const ImportItem&);
 
     void transformStmt(StmtPtr, int);
-    void transformAssertStmt(const AssertStmt&);
-    void transformAssignmentStmt(const AssignmentStmt&);
-    void transformAugmentedAssignmentStmt(const AugmentedAssignmentStmt&);
-    void transformAnnotatedAssignmentStmt(const AnnotatedAssignmentStmt&);
-    void transformDelStmt(const DelStmt&);
-    void transformReturnStmt(const ReturnStmt&);
-    void transformYieldStmt(const YieldStmt&);
-    void transformRaiseStmt(const RaiseStmt&);
-    void transformImportStmt(const ImportStmt&);
-    void transformGlobalStmt(const GlobalStmt&);
-    void transformNonlocalStmt(const NonlocalStmt&);
-    void transformIfStmt(const IfStmt&, int);
-    void transformWhileStmt(const WhileStmt&, int);
-    void transformForStmt(const ForStmt&, int);
-    void transformTryStmt(const TryStmt&, int);
-    void transformWithStmt(const WithStmt&, int);
-    void transformFuncdefStmt(const FuncdefStmt&, int);
-    void transformClassdefStmt(const ClassdefStmt&, int);
+    void transformMinifiedStmt(StmtPtr, int);
+    void visitNoneStmt(const Stmt&, int);
+    void visitExpressionStmt(const ExprStmt&, int);
+    void visitPassStmt(const Stmt&, int);
+    void visitBreakStmt(const Stmt&, int);
+    void visitContinueStmt(const Stmt&, int);
+    void visitErrorStmt(const ErrorStmt&, int);
+    void visitAssertStmt(const AssertStmt&, int);
+    void visitAssignmentStmt(const AssignmentStmt&, int);
+    void visitAugmentedAssignmentStmt(const AugmentedAssignmentStmt&, int);
+    void visitAnnotatedAssignmentStmt(const AnnotatedAssignmentStmt&, int);
+    void visitDelStmt(const DelStmt&, int);
+    void visitReturnStmt(const ReturnStmt&, int);
+    void visitYieldStmt(const YieldStmt&, int);
+    void visitRaiseStmt(const RaiseStmt&, int);
+    void visitImportStmt(const ImportStmt&, int);
+    void visitGlobalStmt(const GlobalStmt&, int);
+    void visitNonlocalStmt(const NonlocalStmt&, int);
+    void visitIfStmt(const IfStmt&, int);
+    void visitWhileStmt(const WhileStmt&, int);
+    void visitForStmt(const ForStmt&, int);
+    void visitTryStmt(const TryStmt&, int);
+    void visitWithStmt(const WithStmt&, int);
+    void visitFuncdefStmt(const FuncdefStmt&, int);
+    void visitClassdefStmt(const ClassdefStmt&, int);
     void transformSuite(const Suite&, int);
 
     void transformDecorator(const Decorator&);
 
     void addText(std::string_view txt) {
-        buffer += txt.data();
+        buffer.append(txt.data(), txt.size());
+
+        if (sink && buffer.size() >= chunkSize) {
+            sendFullChunks();
+        }
+    }
+
+    void sendFullChunks() {
+        auto size = buffer.size() - (buffer.size() % chunkSize);
+        sink->write(std::string_view(buffer.data(), size));
+        sentBytes += size;
+        buffer.erase(0, size);
+    }
+
+    void mapLocation(const Location& location) {
+        if (sourceMap) {
+            sourceMap->addMapping(sentBytes + buffer.size(), location);
+        }
+    }
+
+    // 'spaced' in normal output, 'tight' in minified output
+    void addText(std::string_view spaced, std::string_view tight) {
+        addText(minify ? tight : spaced);
     }
 
     void addNewLine(int indent=0) {
@@ -104,11 +296,55 @@ private:
     }
 
     void addIndent(int amount) {
-        addText(std::string(amount, ' '));
+        static const std::string spaces(256, ' ');
+
+        while (amount > 0) {
+            auto count = std::min<size_t>(amount, spaces.size());
+            addText(std::string_view(spaces.data(), count));
+            amount -= count;
+        }
+    }
+
+    // ends a line left open for more ';'-joined statements, if any
+    void closeLine() {
+        if (openLineIndent >= 0) {
+            addNewLine();
+            openLineIndent = -1;
+        }
+    }
+
+    void startLine(int indent) {
+        closeLine();
+        addIndent(indent);
+    }
+
+    int getIndentStep() const {
+        return minify ? 1 : 4;
     }
 
     std::string buffer;
     bool nextGlobalStmtShouldBeOnANewLine = false;
+    StmtPtr previousGlobalStmt {nullptr};
+
+    bool minify {false};
+    int openLineIndent {-1}; // of the last simple statement, if still open
+
+    OutputSink* sink {nullptr};
+    size_t chunkSize {0};
+    uint64_t sentBytes {0}; // sent to the sink or cleared away
+
+    SourceMap* sourceMap {nullptr};
+    std::string_view originalSource;
+
+    // The binary expressions down a chain of left operands that have been 
+    // opened but whose operators are still to come, innermost last; a 
+    // 'bracketed' one has a ')' to close after its right operand.
+    struct BinaryChainLink {
+        const BinaryExpr* expr;
+        bool bracketed;
+    };
+
+    std::vector<BinaryChainLink> binaryChain;
 };
 
 #include "expr_transform.h"
@@ -0,0 +1,380 @@
+#pragma once
+
+// Compile-time dispatch over the node kinds. A pass derives from 
+// AstVisitor<Pass> and defines a hook for each kind of node, named after 
+// the node's type (visitNameExpr(NameExpr&), visitIfStmt(IfStmt&), ...). 
+// visitExpr/visitStmt pick the hook from the node's kind and call it 
+// directly; there are no virtual calls, and nodes go by reference. Any 
+// extra arguments given to visitExpr/visitStmt are passed on to the hook.
+template <typename Derived, typename ResultT = void>
+class AstVisitor {
+public:
+    template <typename ...Args>
+    ResultT visitExpr(Expr& expr, Args&&... args) {
+        #define VISIT_EXPR(kind, type) \
+            case ExprKind::kind: \
+                return derived().visit##kind##Expr( \
+                    static_cast<type&>(expr), std::forward<Args>(args)... \
+                );
+
+        switch (expr.kind) {
+        VISIT_EXPR(None, Expr)
+        VISIT_EXPR(Name, NameExpr)
+        VISIT_EXPR(StringLiteral, StringLiteralExpr)
+        VISIT_EXPR(IntegerLiteral, IntegerLiteralExpr)
+        VISIT_EXPR(BooleanLiteral, BooleanLiteralExpr)
+        VISIT_EXPR(FloatLiteral, FloatLiteralExpr)
+        VISIT_EXPR(If, IfExpr)
+        VISIT_EXPR(ListDisplay, ListDisplayExpr)
+        VISIT_EXPR(SetDisplay, SetDisplayExpr)
+        VISIT_EXPR(TupleDisplay, TupleDisplayExpr)
+        VISIT_EXPR(DictDisplay, DictDisplayExpr)
+        VISIT_EXPR(Generator, GeneratorExpr)
+        VISIT_EXPR(Yield, YieldExpr)
+        VISIT_EXPR(AttributeRef, AttributeRefExpr)
+        VISIT_EXPR(Subscription, SubscriptionExpr)
+        VISIT_EXPR(Slicing, SlicingExpr)
+        VISIT_EXPR(Call, CallExpr)
+        VISIT_EXPR(Await, AwaitExpr)
+        VISIT_EXPR(Unary, UnaryExpr)
+        VISIT_EXPR(Binary, BinaryExpr)
+        VISIT_EXPR(Lambda, LambdaExpr)
+        }
+
+        #undef VISIT_EXPR
+
+        assert(0);
+        return ResultT();
+    }
+
+    template <typename ...Args>
+    ResultT visitStmt(Stmt& stmt, Args&&... args) {
+        #define VISIT_STMT(kind, type) \
+            case StmtKind::kind: \
+                return derived().visit##kind##Stmt( \
+                    static_cast<type&>(stmt), std::forward<Args>(args)... \
+                );
+
+        switch (stmt.kind) {
+        VISIT_STMT(None, Stmt)
+        VISIT_STMT(Expression, ExprStmt)
+        VISIT_STMT(Assert, AssertStmt)
+        VISIT_STMT(Assignment, AssignmentStmt)
+        VISIT_STMT(AugmentedAssignment, AugmentedAssignmentStmt)
+        VISIT_STMT(AnnotatedAssignment, AnnotatedAssignmentStmt)
+        VISIT_STMT(Pass, Stmt)
+        VISIT_STMT(Del, DelStmt)
+        VISIT_STMT(Return, ReturnStmt)
+        VISIT_STMT(Yield, YieldStmt)
+        VISIT_STMT(Raise, RaiseStmt)
+        VISIT_STMT(Break, Stmt)
+        VISIT_STMT(Continue, Stmt)
+        VISIT_STMT(Import, ImportStmt)
+        VISIT_STMT(Global, GlobalStmt)
+        VISIT_STMT(Nonlocal, NonlocalStmt)
+        VISIT_STMT(If, IfStmt)
+        VISIT_STMT(While, WhileStmt)
+        VISIT_STMT(For, ForStmt)
+        VISIT_STMT(Try, TryStmt)
+        VISIT_STMT(With, WithStmt)
+        VISIT_STMT(Funcdef, FuncdefStmt)
+        VISIT_STMT(Classdef, ClassdefStmt)
+        VISIT_STMT(Error, ErrorStmt)
+        }
+
+        #undef VISIT_STMT
+
+        assert(0);
+        return ResultT();
+    }
+
+protected:
+    Derived& derived() {
+        return static_cast<Derived&>(*this);
+    }
+};
+
+// A visitor whose hooks, unless the pass replaces them, visit every child 
+// of the node in source order and do nothing else. A pass only defines the 
+// hooks for the nodes it cares about, and calls walk* from them to carry on 
+// into the children.
+template <typename Derived>
+class AstWalker : public AstVisitor<Derived> {
+public:
+    using AstVisitor<Derived>::visitExpr;
+    using AstVisitor<Derived>::visitStmt;
+
+    void walk(StmtList& stmts) {
+        for (auto stmt : stmts) {
+            this->derived().visitStmt(*stmt);
+        }
+    }
+
+    void walk(Suite& suite) {
+        walk(suite.stmts);
+    }
+
+    void walk(ExprPtr expr) {
+        if (expr) {
+            this->derived().visitExpr(*expr);
+        }
+    }
+
+    void walk(ExprList& exprs) {
+        for (auto expr : exprs) {
+            walk(expr);
+        }
+    }
+
+    void walk(TargetPtr target) {
+        if (target->kind == TargetKind::Expr) {
+            walk(static_cast<ExprTarget*>(target)->expr);
+            return;
+        }
+
+        for (auto child : static_cast<BrackettedTarget*>(target)->targets) {
+            walk(child);
+        }
+    }
+
+    void walk(TargetList& targets) {
+        for (auto target : targets) {
+            walk(target);
+        }
+    }
+
+    void walk(ArgumentList& arguments) {
+        for (auto& argument : arguments) {
+            walk(argument.value);
+        }
+    }
+
+    void walk(ParameterList& parameters) {
+        for (auto& parameter : parameters) {
+            walk(parameter.hint);
+            walk(parameter.value);
+        }
+    }
+
+    void walk(DecoratorList& decorators) {
+        for (auto& decorator : decorators) {
+            walk(decorator.argumentList);
+        }
+    }
+
+    void walk(CompFor* compFor) {
+        if (compFor) {
+            walk(compFor->targetList);
+            walk(compFor->test);
+            walk(compFor->compIter);
+        }
+    }
+
+    void walk(CompIter* compIter) {
+        if (compIter) {
+            walk(compIter->compFor);
+
+            if (compIter->compIf) {
+                walk(compIter->compIf->exprNoCond);
+                walk(compIter->compIf->compIter);
+            }
+        }
+    }
+
+    void walk(Comprehension* comprehension) {
+        if (comprehension) {
+            walk(comprehension->expr);
+            walk(comprehension->compFor);
+        }
+    }
+
+    // expressions
+    void visitNoneExpr(Expr&) {}
+    void visitNameExpr(NameExpr&) {}
+    void visitStringLiteralExpr(StringLiteralExpr&) {}
+    void visitIntegerLiteralExpr(IntegerLiteralExpr&) {}
+    void visitBooleanLiteralExpr(BooleanLiteralExpr&) {}
+    void visitFloatLiteralExpr(FloatLiteralExpr&) {}
+
+    void visitIfExpr(IfExpr& expr) {
+        walk(expr.thenValue);
+        walk(expr.cond);
+        walk(expr.elseValue);
+    }
+
+    void visitListDisplayExpr(ListDisplayExpr& expr) {
+        walk(expr.starredList);
+        walk(expr.comprehension);
+    }
+
+    void visitSetDisplayExpr(SetDisplayExpr& expr) {
+        walk(expr.items);
+        walk(expr.comprehension);
+    }
+
+    void visitTupleDisplayExpr(TupleDisplayExpr& expr) {
+        walk(expr.items);
+    }
+
+    void visitDictDisplayExpr(DictDisplayExpr& expr) {
+        for (auto& item : expr.itemList) {
+            walk(item.expr1);
+            walk(item.expr2);
+            walk(item.compFor);
+        }
+    }
+
+    void visitGeneratorExpr(GeneratorExpr& expr) {
+        walk(expr.expr);
+        walk(expr.compFor);
+    }
+
+    void visitYieldExpr(YieldExpr& expr) {
+        walk(expr.exprList);
+        walk(expr.fromExpr);
+    }
+
+    void visitAttributeRefExpr(AttributeRefExpr& expr) {
+        walk(expr.primary);
+    }
+
+    void visitSubscriptionExpr(SubscriptionExpr& expr) {
+        walk(expr.primary);
+        walk(expr.exprList);
+    }
+
+    void visitSlicingExpr(SlicingExpr& expr) {
+        walk(expr.primary);
+        walk(expr.lowerBound);
+        walk(expr.upperBound);
+        walk(expr.stride);
+    }
+
+    void visitCallExpr(CallExpr& expr) {
+        walk(expr.primary);
+        walk(expr.argumentList);
+        walk(expr.comprehension);
+    }
+
+    void visitAwaitExpr(AwaitExpr& expr) {
+        walk(expr.primary);
+    }
+
+    void visitUnaryExpr(UnaryExpr& expr) {
+        walk(expr.expr);
+    }
+
+    void visitBinaryExpr(BinaryExpr& expr) {
+        walk(expr.lhs);
+        walk(expr.rhs);
+    }
+
+    void visitLambdaExpr(LambdaExpr& expr) {
+        walk(expr.parameterList);
+        walk(expr.expr);
+    }
+
+    // statements
+    void visitNoneStmt(Stmt&) {}
+    void visitPassStmt(Stmt&) {}
+    void visitBreakStmt(Stmt&) {}
+    void visitContinueStmt(Stmt&) {}
+    void visitImportStmt(ImportStmt&) {}
+    void visitGlobalStmt(GlobalStmt&) {}
+    void visitNonlocalStmt(NonlocalStmt&) {}
+    void visitErrorStmt(ErrorStmt&) {}
+
+    void visitExpressionStmt(ExprStmt& stmt) {
+        walk(stmt.expr);
+    }
+
+    void visitAssertStmt(AssertStmt& stmt) {
+        walk(stmt.expr1);
+        walk(stmt.expr2);
+    }
+
+    void visitAssignmentStmt(AssignmentStmt& stmt) {
+        walk(stmt.targetList);
+        walk(stmt.value);
+    }
+
+    void visitAugmentedAssignmentStmt(AugmentedAssignmentStmt& stmt) {
+        walk(stmt.autoTarget);
+        walk(stmt.values);
+    }
+
+    void visitAnnotatedAssignmentStmt(AnnotatedAssignmentStmt& stmt) {
+        walk(stmt.autoTarget);
+        walk(stmt.annotation);
+        walk(stmt.value);
+    }
+
+    void visitDelStmt(DelStmt& stmt) {
+        walk(stmt.targetList);
+    }
+
+    void visitReturnStmt(ReturnStmt& stmt) {
+        walk(stmt.exprList);
+    }
+
+    void visitYieldStmt(YieldStmt& stmt) {
+        walk(stmt.expr);
+    }
+
+    void visitRaiseStmt(RaiseStmt& stmt) {
+        walk(stmt.expr);
+        walk(stmt.fromExpr);
+    }
+
+    void visitIfStmt(IfStmt& stmt) {
+        for (auto& [condition, suite] : stmt.suites) {
+            walk(condition);
+            walk(suite);
+        }
+        walk(stmt.elseSuite);
+    }
+
+    void visitWhileStmt(WhileStmt& stmt) {
+        walk(stmt.expr);
+        walk(stmt.suite);
+        walk(stmt.elseSuite);
+    }
+
+    void visitForStmt(ForStmt& stmt) {
+        walk(stmt.exprList);
+        walk(stmt.suite);
+        walk(stmt.elseSuite);
+    }
+
+    void visitTryStmt(TryStmt& stmt) {
+        walk(stmt.suite);
+
+        for (auto& handler : stmt.exceptList) {
+            walk(handler.expr);
+            walk(handler.suite);
+        }
+
+        walk(stmt.elseSuite);
+        walk(stmt.finallySuite);
+    }
+
+    void visitWithStmt(WithStmt& stmt) {
+        for (auto& item : stmt.items) {
+            walk(item.expr);
+        }
+        walk(stmt.suite);
+    }
+
+    void visitFuncdefStmt(FuncdefStmt& stmt) {
+        walk(stmt.decorators);
+        walk(stmt.parameterList);
+        walk(stmt.hint);
+        walk(stmt.getSuite());
+    }
+
+    void visitClassdefStmt(ClassdefStmt& stmt) {
+        walk(stmt.decorators);
+        walk(stmt.argumentList);
+        walk(stmt.suite);
+    }
+};
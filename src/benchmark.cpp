@@ -0,0 +1,912 @@
+// Throughput benchmarks for the front end.
+//
+//     g++ -std=c++17 -O2 -pthread -I src src/benchmark.cpp -o benchmark
+//     ./benchmark [--runs N] path...
+//
+// Directories are searched for '.py' files. With no paths given, 
+// "sample.py" is used. The process fails if a file does not come out of 
+// the transformer the same way a second time round.
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cassert>
+
+#include "common/common.h"
+#include "lexing/lexer.h"
+#include "ast/ast.h"
+#include "ast/to_src/to_src.h"
+#include "parsing/parser.cpp"
+#include "driver/driver.h"
+
+using BenchmarkClock = std::chrono::steady_clock;
+
+struct BenchmarkResult {
+    size_t bytes {0};
+    size_t items {0};
+    double seconds {0};
+};
+
+BenchmarkResult benchmarkLexer(const std::vector<std::string>& files) {
+    BenchmarkResult result;
+    auto start = BenchmarkClock::now();
+
+    for (auto& file : files) {
+        Diagnostics diagnostics;
+        Lexer lexer(&diagnostics);
+        if (not lexer.useFile(file)) {
+            Console::writeLine("could not open '", file, "'");
+            exit(1);
+        }
+
+        Token token;
+        lexer.readToken(token);
+        result.items++;
+
+        while (token.kind != TokenKind::EndOfFile) {
+            lexer.readToken(token);
+            result.items++;
+        }
+    }
+
+    result.seconds = std::chrono::duration<double>(
+        BenchmarkClock::now() - start
+    ).count();
+
+    return result;
+}
+
+// whether the lexer gets to the end of the file without a fatal error
+bool canLexFile(const std::string& file) {
+    Diagnostics diagnostics;
+    Lexer lexer(&diagnostics);
+
+    if (not lexer.useFile(file)) {
+        return false;
+    }
+
+    try {
+        Token token;
+        do {
+            lexer.readToken(token);
+        } while (token.kind != TokenKind::EndOfFile);
+    }
+    catch (const FatalError&) {
+        return false;
+    }
+
+    return true;
+}
+
+TokenKind getKindOfWordFromMap(std::string_view value) {
+    if (auto it = stringTokenMap.find(value); 
+        it != std::end(stringTokenMap)) {
+        return it->second;
+    }
+    return TokenKind::Identifier;
+}
+
+// Looks up every word of the given files 'repetitions' times, through 
+// either the switch in getKindOfWord or the std::map it replaced.
+template <typename LookupT>
+BenchmarkResult benchmarkKeywordLookup(
+    const std::vector<std::string>& words, 
+    int repetitions,
+    LookupT lookup
+) {
+    BenchmarkResult result;
+    size_t keywords = 0;
+
+    auto start = BenchmarkClock::now();
+
+    for (int i = 0; i < repetitions; ++i) {
+        for (auto& word : words) {
+            keywords += lookup(word) != TokenKind::Identifier;
+        }
+    }
+
+    result.seconds = std::chrono::duration<double>(
+        BenchmarkClock::now() - start
+    ).count();
+    result.items = words.size() * repetitions;
+
+    // keeps the lookups from being optimized away
+    if (keywords == size_t(-1)) {
+        Console::writeLine(keywords);
+    }
+
+    return result;
+}
+
+std::vector<std::string> collectWords(const std::vector<std::string>& files) {
+    std::vector<std::string> words;
+
+    for (auto& file : files) {
+        Diagnostics diagnostics;
+        Lexer lexer(&diagnostics);
+        if (not lexer.useFile(file)) {
+            continue;
+        }
+
+        Token token;
+        do {
+            lexer.readToken(token);
+
+            // ...every keyword and identifier, as seen by getKindOfWord; 
+            // "not in" and "is not" are put together by the lexer
+            if (
+                (token.value.find(' ') == std::string_view::npos)
+                && (
+                    (token.kind == TokenKind::Identifier) 
+                    || (getKindOfWordFromMap(token.value) != TokenKind::Identifier)
+                )
+            ) {
+                words.emplace_back(token.value);
+            }
+        } while (token.kind != TokenKind::EndOfFile);
+    }
+
+    return words;
+}
+
+void reportResult(
+    const char* name, 
+    const char* unit, 
+    const BenchmarkResult& result
+) {
+    Console::write(
+        name, ": ",
+        result.items, " ", unit, " in ", result.seconds * 1000, " ms, ",
+        static_cast<size_t>(result.items / result.seconds), " ", unit, "/s"
+    );
+
+    if (result.bytes > 0) {
+        Console::write(
+            ", ", result.bytes / result.seconds / (1024 * 1024), " MB/s"
+        );
+    }
+
+    Console::writeLine();
+}
+
+// The times of one phase of the round trip over the whole corpus, one 
+// for every run.
+struct PhaseTimes {
+    const char* name;
+    std::vector<double> seconds;
+};
+
+// What a round trip over the corpus goes through, the same on every run.
+struct CorpusCounts {
+    size_t bytes {0};
+    size_t tokens {0};
+    size_t nodes {0};
+};
+
+class NodeCounter : public AstWalker<NodeCounter> {
+public:
+    void visitExpr(Expr& expr) {
+        nodes++;
+        AstWalker::visitExpr(expr);
+    }
+
+    void visitStmt(Stmt& stmt) {
+        nodes++;
+        AstWalker::visitStmt(stmt);
+    }
+
+    size_t nodes {0};
+};
+
+// Marks every 'every'-th statement and expression dirty, as a pass that 
+// changed them would; 0 marks none.
+class DirtyMarker : public AstWalker<DirtyMarker> {
+public:
+    explicit DirtyMarker(size_t every)
+        : every(every) {}
+
+    void visitExpr(Expr& expr) {
+        expr.dirty = expr.dirty || isNext();
+        AstWalker::visitExpr(expr);
+    }
+
+    void visitStmt(Stmt& stmt) {
+        stmt.dirty = stmt.dirty || isNext();
+        AstWalker::visitStmt(stmt);
+    }
+
+private:
+    bool isNext() {
+        return (every != 0) && (++nodes % every == 0);
+    }
+
+    size_t every;
+    size_t nodes {0};
+};
+
+double getSeconds(BenchmarkClock::time_point start) {
+    return std::chrono::duration<double>(BenchmarkClock::now() - start).count();
+}
+
+// the nearest-rank percentile of a set of times
+double getPercentile(std::vector<double> values, double percent) {
+    std::sort(std::begin(values), std::end(values));
+    auto rank = static_cast<size_t>(percent / 100 * (values.size() - 1) + 0.5);
+    return values[rank];
+}
+
+// parses a file; syntax errors are recovered from and counted
+size_t parseFile(
+    const std::string& file, 
+    Arena& arena, 
+    std::vector<StmtPtr>& statements
+) {
+    Diagnostics diagnostics;
+    Lexer lexer(&diagnostics);
+
+    if (not lexer.useFile(file)) {
+        Console::writeLine("could not open '", file, "'");
+        exit(1);
+    }
+
+    try {
+        Parser parser(&lexer, &arena, &diagnostics);
+        parser.enableErrorRecovery();
+        parser.parseStmtList(statements);
+    }
+    catch (const FatalError&) {
+        return diagnostics.getNumberOfErrors() + 1;
+    }
+
+    return diagnostics.getNumberOfErrors();
+}
+
+std::string transformStatements(
+    const std::vector<StmtPtr>& statements, 
+    size_t sourceBytes, 
+    bool minify = false
+) {
+    PythonAstTransformer transformer;
+    transformer.reserveForSource(sourceBytes);
+
+    if (minify) {
+        transformer.enableMinifiedOutput();
+    }
+
+    for (auto stmt : statements) {
+        transformer.appendStmt(stmt);
+    }
+
+    transformer.flush();
+    return transformer.takeBuffer();
+}
+
+// Transforms 'statements' into 'sink', a chunk of 'chunkSize' bytes at a 
+// time.
+void streamStatements(
+    const std::vector<StmtPtr>& statements, 
+    OutputSink& sink, 
+    size_t chunkSize
+) {
+    PythonAstTransformer transformer;
+    transformer.setOutputSink(&sink, chunkSize);
+
+    for (auto stmt : statements) {
+        transformer.appendStmt(stmt);
+    }
+
+    transformer.flush();
+}
+
+// Runs read -> lex -> parse -> transform over every file once, adding the 
+// time of each phase to 'times'. Lexing is timed on its own and again as 
+// part of parsing, since the parser pulls its tokens as it goes. A parse 
+// that leaves function bodies for later, and one of every file in parts on 
+// 'pool', are timed next to the full one, as is a transform that sends its 
+// output to a sink in chunks.
+void runRoundTrip(
+    const std::vector<std::string>& files, 
+    std::vector<PhaseTimes>& times, 
+    CorpusCounts& counts,
+    ThreadPool& pool
+) {
+    double readSeconds = 0;
+    double lexSeconds = 0;
+    double parseSeconds = 0;
+    double lazyParseSeconds = 0;
+    double partsParseSeconds = 0;
+    double transformSeconds = 0;
+    double streamSeconds = 0;
+
+    counts = CorpusCounts();
+
+    for (auto& file : files) {
+        auto start = BenchmarkClock::now();
+        auto source = readFile(file);
+        readSeconds += getSeconds(start);
+        counts.bytes += source.size();
+
+        start = BenchmarkClock::now();
+        {
+            Diagnostics diagnostics;
+            Lexer lexer(&diagnostics);
+
+            if (not lexer.useFile(file)) {
+                Console::writeLine("could not open '", file, "'");
+                exit(1);
+            }
+
+            Token token;
+            do {
+                lexer.readToken(token);
+                counts.tokens++;
+            } while (token.kind != TokenKind::EndOfFile);
+        }
+        lexSeconds += getSeconds(start);
+
+        Arena arena;
+        std::vector<StmtPtr> statements;
+
+        start = BenchmarkClock::now();
+        parseFile(file, arena, statements);
+        parseSeconds += getSeconds(start);
+
+        start = BenchmarkClock::now();
+        {
+            // nothing asks for the bodies, so the lexer need not outlive 
+            // the statements
+            Diagnostics diagnostics;
+            Lexer lexer(&diagnostics);
+            Arena lazyArena;
+            std::vector<StmtPtr> lazyStatements;
+
+            if (not lexer.useFile(file)) {
+                Console::writeLine("could not open '", file, "'");
+                exit(1);
+            }
+
+            try {
+                Parser parser(&lexer, &lazyArena, &diagnostics);
+                parser.enableErrorRecovery();
+                parser.enableLazyFunctionBodies();
+                parser.parseStmtList(lazyStatements);
+            }
+            catch (const FatalError&) {}
+
+            lazyParseSeconds += getSeconds(start);
+        }
+
+        start = BenchmarkClock::now();
+        {
+            Module module;
+            Diagnostics diagnostics;
+
+            module.fileName = file;
+            parseModuleInParts(module, diagnostics, pool);
+            partsParseSeconds += getSeconds(start);
+        }
+
+        start = BenchmarkClock::now();
+        auto output = transformStatements(statements, source.size());
+        transformSeconds += getSeconds(start);
+
+        size_t streamedBytes = 0;
+        OutputSink sink([&streamedBytes](std::string_view chunk) {
+            streamedBytes += chunk.size();
+        });
+
+        start = BenchmarkClock::now();
+        streamStatements(statements, sink, 64 * 1024);
+        streamSeconds += getSeconds(start);
+
+        NodeCounter counter;
+        counter.walk(statements);
+        counts.nodes += counter.nodes;
+
+        // keeps the output from being optimized away
+        if (output.size() + streamedBytes == size_t(-1)) {
+            Console::writeLine(output);
+        }
+    }
+
+    times[0].seconds.push_back(readSeconds);
+    times[1].seconds.push_back(lexSeconds);
+    times[2].seconds.push_back(parseSeconds);
+    times[3].seconds.push_back(lazyParseSeconds);
+    times[4].seconds.push_back(partsParseSeconds);
+    times[5].seconds.push_back(transformSeconds);
+    times[6].seconds.push_back(streamSeconds);
+}
+
+// Writes 'output' to 'outputFile' and parses it back into 'statements'.
+bool reparseOutput(
+    const std::string& output, 
+    const std::string& outputFile, 
+    Arena& arena, 
+    std::vector<StmtPtr>& statements
+) {
+    {
+        std::ofstream stream(outputFile, std::ios::binary);
+        stream << output;
+    }
+
+    return parseFile(outputFile, arena, statements) == 0;
+}
+
+// Tells whether 'second' is the same as 'first', saying where not.
+bool checkSameOutput(
+    const std::string& file, 
+    const std::string& what, 
+    const std::string& first, 
+    const std::string& second
+) {
+    if (second == first) {
+        return true;
+    }
+
+    auto mismatch = std::mismatch(
+        std::begin(first), std::end(first), 
+        std::begin(second), std::end(second)
+    ).first - std::begin(first);
+
+    Console::writeLine(file, ": ", what, ", from byte ", mismatch);
+    return false;
+}
+
+// Checks that transforming the output of the transformer gives the same 
+// output again, in normal and in minified mode. Since a minified output 
+// that loses meaning can still be stable, the normal output of the parsed 
+// minified output must also match that of the file. The normal round trip 
+// is also made with the output streamed to the file in small chunks, which 
+// must give the same bytes. Last, the file is transformed on 'pool' with 
+// the source of what is not dirty copied, first with nothing dirty and 
+// then with some nodes dirty; the normal output of what that gives must 
+// match that of the file too. Files with syntax errors are left out, since 
+// what the parser recovers is not meant to survive a round trip.
+bool checkIdempotence(
+    const std::vector<std::string>& files, 
+    ThreadPool& pool
+) {
+    auto outputFile = (
+        std::filesystem::temp_directory_path() / "pet_benchmark_round_trip.py"
+    ).string();
+    bool idempotent = true;
+
+    for (auto& file : files) {
+        Arena arena;
+        std::vector<StmtPtr> statements;
+
+        if (parseFile(file, arena, statements) != 0) {
+            Console::writeLine(file, ": has syntax errors, not checked");
+            continue;
+        }
+
+        auto normal = transformStatements(statements, 0);
+        auto minified = transformStatements(statements, 0, true);
+
+        Arena normalArena;
+        std::vector<StmtPtr> normalStatements;
+
+        auto parsed = reparseOutput(
+            normal, outputFile, normalArena, normalStatements
+        );
+
+        if (not parsed) {
+            Console::writeLine(file, ": the transformed output does not parse");
+            idempotent = false;
+            continue;
+        }
+
+        idempotent &= checkSameOutput(
+            file, 
+            "the transformed output changes when transformed again", 
+            normal, 
+            transformStatements(normalStatements, normal.size())
+        );
+
+        Arena minifiedArena;
+        std::vector<StmtPtr> minifiedStatements;
+
+        parsed = reparseOutput(
+            minified, outputFile, minifiedArena, minifiedStatements
+        );
+
+        if (not parsed) {
+            Console::writeLine(file, ": the minified output does not parse");
+            idempotent = false;
+            continue;
+        }
+
+        idempotent &= checkSameOutput(
+            file, 
+            "the minified output changes when minified again", 
+            minified, 
+            transformStatements(minifiedStatements, minified.size(), true)
+        );
+        idempotent &= checkSameOutput(
+            file, 
+            "the minified output does not mean what the file does", 
+            normal, 
+            transformStatements(minifiedStatements, normal.size())
+        );
+
+        // chunks this small split many statements and lines between them
+        constexpr size_t chunkSize = 4096;
+
+        {
+            std::ofstream stream(outputFile, std::ios::binary);
+            OutputSink sink(stream);
+            streamStatements(statements, sink, chunkSize);
+        }
+
+        Arena streamedArena;
+        std::vector<StmtPtr> streamedStatements;
+
+        if (parseFile(outputFile, streamedArena, streamedStatements) != 0) {
+            Console::writeLine(file, ": the streamed output does not parse");
+            idempotent = false;
+            continue;
+        }
+
+        std::string streamed;
+        OutputSink sink([&streamed](std::string_view chunk) {
+            streamed.append(chunk);
+        });
+        streamStatements(streamedStatements, sink, chunkSize);
+
+        idempotent &= checkSameOutput(
+            file, 
+            "the streamed output differs from the buffered one", 
+            normal, 
+            readFile(outputFile)
+        );
+        idempotent &= checkSameOutput(
+            file, 
+            "the streamed output changes when streamed again", 
+            normal, 
+            streamed
+        );
+
+        auto source = readFile(file);
+
+        for (size_t every : { 0, 7 }) {
+            DirtyMarker marker(every);
+            marker.walk(statements);
+            propagateDirtiness(statements);
+
+            std::string copied;
+            OutputSink copySink([&copied](std::string_view chunk) {
+                copied.append(chunk);
+            });
+            transformModule(statements, copySink, pool, false, nullptr, source);
+
+            Arena copiedArena;
+            std::vector<StmtPtr> copiedStatements;
+
+            parsed = reparseOutput(
+                copied, outputFile, copiedArena, copiedStatements
+            );
+
+            if (not parsed) {
+                Console::writeLine(file, ": the copied output does not parse");
+                idempotent = false;
+                break;
+            }
+
+            idempotent &= checkSameOutput(
+                file, 
+                "the copied output does not mean what the file does", 
+                normal, 
+                transformStatements(copiedStatements, normal.size())
+            );
+        }
+    }
+
+    std::remove(outputFile.c_str());
+    return idempotent;
+}
+
+void reportPhase(const PhaseTimes& phase, const CorpusCounts& counts) {
+    auto median = getPercentile(phase.seconds, 50);
+
+    Console::writeLine(
+        phase.name, ": ",
+        getPercentile(phase.seconds, 0) * 1000, " ms min, ",
+        median * 1000, " ms p50, ",
+        getPercentile(phase.seconds, 90) * 1000, " ms p90, ",
+        getPercentile(phase.seconds, 100) * 1000, " ms max; at p50 ",
+        counts.bytes / median / (1024 * 1024), " MB/s, ",
+        static_cast<size_t>(counts.tokens / median), " tokens/s, ",
+        static_cast<size_t>(counts.nodes / median), " nodes/s"
+    );
+}
+
+// Appends an arithmetic or bitwise expression 'depth' brackets deep.
+void appendArithmeticExpr(
+    std::string& out, 
+    std::minstd_rand& random, 
+    int depth
+) {
+    static const char* operators[] = {
+        " + ", " - ", " * ", " / ", " // ", " % ", " << ", " >> ", 
+        " & ", " | ", " ^ ", " ** "
+    };
+    static const char* operands[] = { 
+        "a", "b", "count", "x.y", "f(n)", "7", "2.5" 
+    };
+
+    auto operandCount = 2 + random() % 4;
+
+    for (size_t i = 0; i < operandCount; ++i) {
+        auto op = (i == 0) 
+            ? "" 
+            : operators[random() % std::size(operators)];
+        out += op;
+
+        if ((depth > 0) && (random() % 3 == 0)) {
+            out += '(';
+            appendArithmeticExpr(out, random, depth - 1);
+            out += ')';
+        }
+        else {
+            // nothing but an operand may follow '**'
+            auto isPow = (op == operators[std::size(operators) - 1]);
+
+            if (not isPow && (random() % 4 == 0)) {
+                out += '-';
+            }
+            out += operands[random() % std::size(operands)];
+        }
+    }
+}
+
+// Writes a file of long boolean, comparison and arithmetic expressions, 
+// which spends nearly all of the parser's time in expressions, and 
+// returns its name.
+std::string writeExpressionCorpus(size_t lines) {
+    static const char* comparisons[] = { 
+        " < ", " <= ", " == ", " != ", " > ", " >= ", " in ", " not in ", 
+        " is ", " is not " 
+    };
+
+    std::minstd_rand random(2024);
+    std::string source;
+
+    for (size_t line = 0; line < lines; ++line) {
+        source += "value = ";
+
+        auto andCount = 1 + random() % 3;
+
+        for (size_t i = 0; i < andCount; ++i) {
+            if (i != 0) {
+                source += (random() % 2) ? " and " : " or ";
+            }
+
+            if (random() % 4 == 0) {
+                source += "not ";
+            }
+
+            // a bracketed comparison on the left, as in (a < b) < c, is 
+            // not a chain and must keep its brackets
+            auto bracketed = (random() % 8 == 0);
+
+            if (bracketed) {
+                source += '(';
+                appendArithmeticExpr(source, random, 2);
+                source += comparisons[random() % std::size(comparisons)];
+                appendArithmeticExpr(source, random, 2);
+                source += ')';
+            }
+            else {
+                appendArithmeticExpr(source, random, 2);
+            }
+
+            if (bracketed || (random() % 2)) {
+                source += comparisons[random() % std::size(comparisons)];
+                appendArithmeticExpr(source, random, 2);
+            }
+        }
+
+        source += '\n';
+    }
+
+    auto fileName = (
+        std::filesystem::temp_directory_path() / "pet_benchmark_expressions.py"
+    ).string();
+
+    std::ofstream stream(fileName, std::ios::binary);
+    stream << source;
+    return fileName;
+}
+
+// Times the parser alone on the expression corpus.
+void benchmarkExpressionParsing(int runs) {
+    auto fileName = writeExpressionCorpus(20000);
+
+    PhaseTimes phase { "parse (with lexing)", {} };
+    CorpusCounts counts;
+
+    for (int i = 0; i < runs; ++i) {
+        Arena arena;
+        std::vector<StmtPtr> statements;
+
+        auto start = BenchmarkClock::now();
+        auto errors = parseFile(fileName, arena, statements);
+        phase.seconds.push_back(getSeconds(start));
+
+        if (errors != 0) {
+            Console::writeLine("the expression benchmark does not parse");
+            exit(1);
+        }
+
+        NodeCounter counter;
+        counter.walk(statements);
+        counts.nodes = counter.nodes;
+    }
+
+    counts.bytes = readFile(fileName).size();
+
+    Diagnostics diagnostics;
+    Lexer lexer(&diagnostics);
+
+    if (not lexer.useFile(fileName)) {
+        Console::writeLine("could not open '", fileName, "'");
+        exit(1);
+    }
+
+    Token token;
+    do {
+        lexer.readToken(token);
+        counts.tokens++;
+    } while (token.kind != TokenKind::EndOfFile);
+
+    Console::writeLine(
+        "\nexpressions: ", counts.bytes, " bytes, ", counts.tokens, 
+        " tokens, ", counts.nodes, " nodes, ", runs, " runs"
+    );
+    reportPhase(phase, counts);
+
+    std::remove(fileName.c_str());
+}
+
+int main(int argc, char const *argv[]) {
+    std::vector<std::string> paths;
+    int runs = 5;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+
+        if ((argument == "--runs") && (i + 1 < argc)) {
+            runs = std::stoi(argv[++i]);
+        }
+        else {
+            paths.push_back(std::move(argument));
+        }
+    }
+
+    if (paths.empty()) {
+        paths.push_back("sample.py");
+    }
+
+    Diagnostics diagnostics;
+    auto files = collectSourceFiles(paths, diagnostics);
+
+    // the phases below do not expect the lexer to give up
+    files.erase(
+        std::remove_if(std::begin(files), std::end(files), [](auto& file) {
+            if (canLexFile(file)) {
+                return false;
+            }
+
+            Console::writeLine(file, ": cannot be lexed, left out");
+            return true;
+        }),
+        std::end(files)
+    );
+
+    if (files.empty() || (runs < 1)) {
+        Console::writeLine("nothing to benchmark");
+        return 1;
+    }
+
+    size_t totalBytes = 0;
+
+    for (auto& file : files) {
+        totalBytes += readFile(file).size();
+    }
+
+    BenchmarkResult best;
+
+    for (int i = 0; i < runs; ++i) {
+        auto result = benchmarkLexer(files);
+        if ((i == 0) || (result.seconds < best.seconds)) {
+            best = result;
+        }
+    }
+
+    best.bytes = totalBytes;
+    reportResult("lexer", "tokens", best);
+
+    auto words = collectWords(files);
+
+    for (auto& [word, kind] : stringTokenMap) {
+        // "not in" is put together by the lexer, never looked up as a word
+        if (word.find(' ') == std::string::npos) {
+            words.push_back(word);
+        }
+    }
+
+    for (auto& word : words) {
+        if (getKindOfWord(word) != getKindOfWordFromMap(word)) {
+            Console::writeLine("keyword lookup mismatch on '", word, "'");
+            exit(1);
+        }
+    }
+
+    BenchmarkResult bestMap, bestSwitch;
+
+    for (int i = 0; i < runs; ++i) {
+        auto mapResult = benchmarkKeywordLookup(
+            words, 
+            10, 
+            getKindOfWordFromMap
+        );
+        auto switchResult = benchmarkKeywordLookup(
+            words, 
+            10, 
+            [](std::string_view word) { return getKindOfWord(word); }
+        );
+
+        if ((i == 0) || (mapResult.seconds < bestMap.seconds)) {
+            bestMap = mapResult;
+        }
+
+        if ((i == 0) || (switchResult.seconds < bestSwitch.seconds)) {
+            bestSwitch = switchResult;
+        }
+    }
+
+    reportResult("keywords (std::map)", "lookups", bestMap);
+    reportResult("keywords (switch)", "lookups", bestSwitch);
+
+    std::vector<PhaseTimes> phases = {
+        { "read", {} }, 
+        { "lex", {} }, 
+        { "parse (with lexing)", {} }, 
+        { "parse (lazy function bodies)", {} }, 
+        { "parse (in parts on every thread)", {} }, 
+        { "transform", {} }, 
+        { "transform (to a sink)", {} }
+    };
+    CorpusCounts counts;
+    ThreadPool pool;
+
+    for (int i = 0; i < runs; ++i) {
+        runRoundTrip(files, phases, counts, pool);
+    }
+
+    Console::writeLine(
+        "\nround trip over ", files.size(), " files, ", counts.bytes, 
+        " bytes, ", counts.tokens, " tokens, ", counts.nodes, " nodes, ", 
+        runs, " runs"
+    );
+
+    for (auto& phase : phases) {
+        reportPhase(phase, counts);
+    }
+
+    benchmarkExpressionParsing(runs);
+
+    auto expressionFile = writeExpressionCorpus(2000);
+    files.push_back(expressionFile);
+    auto idempotent = checkIdempotence(files, pool);
+    std::remove(expressionFile.c_str());
+
+    if (not idempotent) {
+        return 1;
+    }
+
+    Console::writeLine("round trip is idempotent");
+    return 0;
+}
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <cstddef>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief      A bump allocator. Objects made in an arena are never freed 
+ *             one by one; they are all destroyed, newest first, and their 
+ *             memory released in bulk when the arena is destroyed or 
+ *             released.
+ */
+class Arena {
+public:
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    Arena(Arena&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    Arena& operator=(Arena&& other) noexcept {
+        if (this != &other) {
+            release();
+            blocks = std::exchange(other.blocks, nullptr);
+            oldestBlock = std::exchange(other.oldestBlock, nullptr);
+            destructors = std::exchange(other.destructors, nullptr);
+            oldestDestructor = std::exchange(other.oldestDestructor, nullptr);
+            position = std::exchange(other.position, nullptr);
+            limit = std::exchange(other.limit, nullptr);
+        }
+        return *this;
+    }
+
+    ~Arena() {
+        release();
+    }
+
+    /**
+     * @brief      Constructs an object of type T inside the arena.
+     *
+     * @param      args  The arguments to pass to T's constructor.
+     *
+     * @tparam     T     The type of the object to make.
+     * @tparam     Args  a generic parameter pack.
+     *
+     * @return     A non-owning pointer to the new object.
+     */
+    template <typename T, typename ...Args>
+    T* make(Args&&... args) {
+        void* memory = allocate(sizeof(T), alignof(T));
+        T* object = new (memory) T(std::forward<Args>(args)...);
+
+        if constexpr (not std::is_trivially_destructible_v<T>) {
+            auto node = new (allocate(sizeof(Destructor), alignof(Destructor))) 
+                Destructor {
+                    [](void* p) { static_cast<T*>(p)->~T(); },
+                    object,
+                    destructors
+                };
+
+            if (destructors == nullptr) {
+                oldestDestructor = node;
+            }
+            destructors = node;
+        }
+
+        return object;
+    }
+
+    /**
+     * @brief      Allocates raw, uninitialized memory.
+     *
+     * @param[in]  size       The number of bytes.
+     * @param[in]  alignment  The alignment, a power of two.
+     *
+     * @return     A pointer to the memory.
+     */
+    void* allocate(size_t size, size_t alignment) {
+        auto aligned = alignUp(position, alignment);
+
+        if ((position == nullptr) || (aligned + size > limit)) {
+            addBlock(size + alignment);
+            aligned = alignUp(position, alignment);
+        }
+
+        position = aligned + size;
+        return aligned;
+    }
+
+    /**
+     * @brief      Takes over the objects and memory of another arena, which 
+     *  is left empty. They are destroyed with this arena's, as if they had 
+     *  been made in it last.
+     *
+     * @param      other  The other arena.
+     */
+    void adopt(Arena& other) {
+        if ((&other == this) || (other.blocks == nullptr)) {
+            return;
+        }
+
+        if (other.destructors) {
+            other.oldestDestructor->next = destructors;
+
+            if (destructors == nullptr) {
+                oldestDestructor = other.oldestDestructor;
+            }
+            destructors = other.destructors;
+        }
+
+        other.oldestBlock->next = blocks;
+
+        if (blocks == nullptr) {
+            oldestBlock = other.oldestBlock;
+        }
+        blocks = other.blocks;
+
+        other.blocks = nullptr;
+        other.oldestBlock = nullptr;
+        other.destructors = nullptr;
+        other.oldestDestructor = nullptr;
+        other.position = nullptr;
+        other.limit = nullptr;
+    }
+
+    /**
+     * @brief      Destroys every object in the arena and frees its memory. 
+     *  The arena can be used again afterwards.
+     */
+    void release() {
+        while (destructors) {
+            destructors->destroy(destructors->object);
+            destructors = destructors->next;
+        }
+
+        while (blocks) {
+            auto next = blocks->next;
+            std::free(blocks);
+            blocks = next;
+        }
+
+        oldestBlock = nullptr;
+        oldestDestructor = nullptr;
+        position = nullptr;
+        limit = nullptr;
+    }
+
+private:
+    struct Destructor {
+        void (*destroy)(void*);
+        void* object;
+        Destructor* next;
+    };
+
+    struct Block {
+        Block* next;
+    };
+
+    static constexpr size_t defaultBlockSize = 64 * 1024;
+
+    static char* alignUp(char* pointer, size_t alignment) {
+        auto value = reinterpret_cast<uintptr_t>(pointer);
+        value = (value + alignment - 1) & ~(uintptr_t(alignment) - 1);
+        return reinterpret_cast<char*>(value);
+    }
+
+    void addBlock(size_t minimumSize) {
+        size_t size = sizeof(Block) + std::max(defaultBlockSize, minimumSize);
+        auto block = static_cast<Block*>(std::malloc(size));
+
+        if (block == nullptr) {
+            throw std::bad_alloc();
+        }
+
+        block->next = blocks;
+
+        if (blocks == nullptr) {
+            oldestBlock = block;
+        }
+        blocks = block;
+
+        position = reinterpret_cast<char*>(block + 1);
+        limit = reinterpret_cast<char*>(block) + size;
+    }
+
+    // both lists run newest first
+    Block* blocks {nullptr};
+    Block* oldestBlock {nullptr};
+    Destructor* destructors {nullptr};
+    Destructor* oldestDestructor {nullptr};
+    char* position {nullptr};
+    char* limit {nullptr};
+};
@@ -57,4 +57,7 @@ std::string convertCodepointToHex(uint32_t codePoint) {
 
 #include "utf8.h"
 #include "io.h"
-#include "errorreporter.h"
+#include "sourcemanager.h"
+#include "diagnostics.h"
+#include "arena.h"
+#include "numbers.h"
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "location.h"
+#include "sourcemanager.h"
+#include "io.h"
+
+enum class Severity : uint8_t {
+    Error,
+    Warning,
+    Note,   // more detail on the message before it
+};
+
+// A single message. Its line and column are only worked out when it is 
+// written out, so that reporting it does not touch the SourceManager.
+struct Diagnostic {
+    Severity severity;
+    Location location;
+    std::string message;
+};
+
+// Thrown by Diagnostics::reportFatalError once the message is recorded; 
+// whoever started the parse catches it and gives up on that file.
+struct FatalError {};
+
+/**
+ * @brief      Collects the messages of one lexer/parser. A Diagnostics is 
+ *             only ever used by one thread, so reporting takes no locks 
+ *             and writes nothing out; the messages are handed to a 
+ *             DiagnosticSession when the work is done.
+ */
+class Diagnostics {
+public:
+    void reportError(const std::string& message) {
+        add(Severity::Error, message, Location());
+        numberOfErrors++;
+    }
+
+    void reportError(const std::string& message, const Location& location) {
+        add(Severity::Error, message, location);
+        numberOfErrors++;
+    }
+
+    template <typename ...Args>
+    [[noreturn]] void reportFatalError(Args&&... args) {
+        reportError(std::forward<Args>(args)...);
+        throw FatalError();
+    }
+
+    void reportWarning(const std::string& message) {
+        add(Severity::Warning, message, Location());
+        numberOfWarnings++;
+    }
+
+    void reportWarning(const std::string& message, const Location& location) {
+        add(Severity::Warning, message, location);
+        numberOfWarnings++;
+    }
+
+    void elaborate(const std::string& message) {
+        add(Severity::Note, message, Location());
+    }
+
+    void elaborate(const std::string& message, const Location& location) {
+        add(Severity::Note, message, location);
+    }
+
+    // moves the messages of 'other' to the end of these
+    void append(Diagnostics&& other) {
+        diagnostics.insert(
+            std::end(diagnostics),
+            std::make_move_iterator(std::begin(other.diagnostics)),
+            std::make_move_iterator(std::end(other.diagnostics))
+        );
+        numberOfErrors += other.numberOfErrors;
+        numberOfWarnings += other.numberOfWarnings;
+
+        other.diagnostics.clear();
+        other.numberOfErrors = 0;
+        other.numberOfWarnings = 0;
+    }
+
+    size_t getNumberOfErrors() const {
+        return numberOfErrors;
+    }
+
+    size_t getNumberOfWarnings() const {
+        return numberOfWarnings;
+    }
+
+    bool empty() const {
+        return diagnostics.empty();
+    }
+
+    const std::vector<Diagnostic>& getDiagnostics() const {
+        return diagnostics;
+    }
+
+private:
+    void add(Severity severity, const std::string& message, Location location) {
+        diagnostics.push_back({ severity, location, message });
+    }
+
+    std::vector<Diagnostic> diagnostics;
+    size_t numberOfErrors {0};
+    size_t numberOfWarnings {0};
+};
+
+/**
+ * @brief      Gathers the diagnostics of every file in a run. Workers 
+ *             publish their batches without locking; everything is 
+ *             written out at the end, ordered by file name.
+ */
+class DiagnosticSession {
+public:
+    DiagnosticSession() = default;
+    DiagnosticSession(const DiagnosticSession&) = delete;
+
+    ~DiagnosticSession() {
+        deleteBatches(head.exchange(nullptr));
+    }
+
+    /**
+     * @brief      Hands over the diagnostics of one file.
+     *
+     * @param[in]  fileName     The file the diagnostics belong to.
+     * @param      diagnostics  The diagnostics.
+     */
+    void publish(std::string fileName, Diagnostics&& diagnostics) {
+        numberOfErrors += diagnostics.getNumberOfErrors();
+        numberOfWarnings += diagnostics.getNumberOfWarnings();
+
+        if (diagnostics.empty()) {
+            return;
+        }
+
+        auto batch = new Batch {std::move(fileName), std::move(diagnostics)};
+        batch->next = head.load(std::memory_order_relaxed);
+
+        while (not head.compare_exchange_weak(
+            batch->next, 
+            batch, 
+            std::memory_order_release, 
+            std::memory_order_relaxed
+        ));
+    }
+
+    size_t getNumberOfErrors() const {
+        return numberOfErrors;
+    }
+
+    size_t getNumberOfWarnings() const {
+        return numberOfWarnings;
+    }
+
+    /**
+     * @brief      Writes out everything published so far, file by file, 
+     *  and forgets it. Batches of the same file keep the order in which 
+     *  they were published.
+     */
+    void print() {
+        std::vector<Batch*> batches;
+
+        for (auto batch = head.exchange(nullptr, std::memory_order_acquire); 
+            batch; batch = batch->next) {
+            batches.push_back(batch);
+        }
+
+        std::reverse(std::begin(batches), std::end(batches));
+        std::stable_sort(std::begin(batches), std::end(batches), 
+            [](auto a, auto b) { return a->fileName < b->fileName; }
+        );
+
+        uint32_t lastFileId = 0;
+
+        for (auto batch : batches) {
+            for (auto& diagnostic : batch->diagnostics.getDiagnostics()) {
+                print(diagnostic, lastFileId);
+            }
+        }
+
+        for (auto batch : batches) {
+            delete batch;
+        }
+    }
+
+private:
+    struct Batch {
+        std::string fileName;
+        Diagnostics diagnostics;
+        Batch* next {nullptr};
+    };
+
+    static void print(const Diagnostic& diagnostic, uint32_t& lastFileId) {
+        const char* prefix = "    [error]";
+
+        if (diagnostic.severity == Severity::Warning) {
+            prefix = "    [warning]";
+        }
+        else if (diagnostic.severity == Severity::Note) {
+            prefix = "        ...";
+        }
+
+        if (diagnostic.location.fileId == 0) {
+            Console::writeLine(prefix, ": ", diagnostic.message);
+
+            if (diagnostic.severity != Severity::Note) {
+                lastFileId = 0;
+            }
+            return;
+        }
+
+        if (lastFileId != diagnostic.location.fileId) {
+            Console::writeLine(
+                "\nin file '", 
+                getSourceManager().getFileName(diagnostic.location.fileId), 
+                "':"
+            );
+            lastFileId = diagnostic.location.fileId;
+        }
+
+        auto position = getSourceManager().resolve(diagnostic.location);
+
+        Console::writeLine(
+            prefix, " on (", position.line, ",", position.column, "): ",
+            diagnostic.message
+        );
+    }
+
+    static void deleteBatches(Batch* batch) {
+        while (batch) {
+            delete std::exchange(batch, batch->next);
+        }
+    }
+
+    std::atomic<Batch*> head {nullptr};
+    std::atomic<size_t> numberOfErrors {0};
+    std::atomic<size_t> numberOfWarnings {0};
+};
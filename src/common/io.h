@@ -1,7 +1,16 @@
 #pragma once
 
+#include <cerrno>
 #include <fstream>
+#include <functional>
 #include <string>
+#include <string_view>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 /**
  * @brief      Attempts to open a file with the given name using the 
@@ -74,6 +83,251 @@ std::string readFile(const std::string& fileName) {
     return buffer;
 }
 
+/**
+ * @brief      Read-only view of a source file's bytes.
+ *
+ *             Regular files are memory-mapped so that the lexer walks the
+ *             mapped pages directly and nothing is copied. Anything that
+ *             cannot be mapped (pipes, terminals, stdin) is read with
+ *             read() into an owned buffer instead.
+ */
+class SourceBuffer {
+public:
+    SourceBuffer() = default;
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+    SourceBuffer(SourceBuffer&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    SourceBuffer& operator=(SourceBuffer&& other) noexcept {
+        if (this != &other) {
+            release();
+            fallback = std::move(other.fallback);
+            mapped = std::exchange(other.mapped, false);
+            length = std::exchange(other.length, 0);
+            data = mapped ? std::exchange(other.data, nullptr) : fallback.data();
+            other.data = nullptr;
+        }
+        return *this;
+    }
+
+    ~SourceBuffer() {
+        release();
+    }
+
+    /**
+     * @brief      Opens the file with the given name. The name "-" refers 
+     *  to the standard input.
+     *
+     * @param[in]  fileName  The file name.
+     *
+     * @return     An indication of whether the file was opened and read.
+     */
+    [[nodiscard]]
+    bool open(const std::string& fileName) {
+        if (fileName == "-") {
+            return readDescriptor(STDIN_FILENO);
+        }
+
+        int fd = ::open(fileName.data(), O_RDONLY);
+
+        if (fd < 0) {
+            return false;
+        }
+
+        bool result = openDescriptor(fd);
+        ::close(fd);
+
+        return result;
+    }
+
+    /**
+     * @brief      Maps the given file descriptor, or reads it if it is 
+     *  not a regular file. The descriptor is not closed.
+     *
+     * @param[in]  fd    The file descriptor.
+     *
+     * @return     An indication of whether the data was obtained.
+     */
+    [[nodiscard]]
+    bool openDescriptor(int fd) {
+        release();
+
+        struct stat info;
+
+        if ((fstat(fd, &info) != 0) || (not S_ISREG(info.st_mode))) {
+            return readDescriptor(fd);
+        }
+
+        if (info.st_size == 0) {
+            data = fallback.data();
+            return true;
+        }
+
+        void* address = mmap(
+            nullptr, 
+            info.st_size, 
+            PROT_READ, 
+            MAP_PRIVATE, 
+            fd, 
+            0
+        );
+
+        if (address == MAP_FAILED) {
+            return readDescriptor(fd);
+        }
+
+        madvise(address, info.st_size, MADV_SEQUENTIAL);
+
+        data = static_cast<const char*>(address);
+        length = info.st_size;
+        mapped = true;
+
+        return true;
+    }
+
+    const char* begin() const {
+        return data;
+    }
+
+    const char* end() const {
+        return data + length;
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+    std::string_view view() const {
+        return std::string_view(data, length);
+    }
+
+    bool isMapped() const {
+        return mapped;
+    }
+
+private:
+    bool readDescriptor(int fd) {
+        release();
+
+        char chunk[64 * 1024];
+
+        while (1) {
+            auto count = ::read(fd, chunk, sizeof(chunk));
+
+            if (count == 0) {
+                break;
+            }
+
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                fallback.clear();
+                return false;
+            }
+
+            fallback.append(chunk, count);
+        }
+
+        data = fallback.data();
+        length = fallback.size();
+
+        return true;
+    }
+
+    void release() {
+        if (mapped) {
+            munmap(const_cast<char*>(data), length);
+        }
+
+        fallback.clear();
+        data = fallback.data();
+        length = 0;
+        mapped = false;
+    }
+
+    std::string fallback;
+    const char* data {fallback.data()};
+    size_t length {0};
+    bool mapped {false};
+};
+
+/**
+ * @brief      Somewhere to send output a chunk at a time: a file 
+ *             descriptor, a stream, or a function of the caller's. 
+ *             A sink only passes the bytes on; it keeps nothing itself.
+ */
+class OutputSink {
+public:
+    using Callback = std::function<void(std::string_view)>;
+
+    // the descriptor is not closed by the sink
+    explicit OutputSink(int fd)
+        : fd(fd) {}
+
+    // the stream must outlive the sink
+    explicit OutputSink(std::ostream& stream)
+        : stream(&stream) {}
+
+    explicit OutputSink(Callback callback)
+        : callback(std::move(callback)) {}
+
+    OutputSink(const OutputSink&) = delete;
+
+    /**
+     * @brief      Passes a chunk on. Once a write to the descriptor or 
+     *  stream has failed, the rest of the output is dropped.
+     *
+     * @param[in]  chunk  The chunk.
+     */
+    void write(std::string_view chunk) {
+        if (failed) {
+            return;
+        }
+
+        if (stream) {
+            stream->write(chunk.data(), chunk.size());
+            failed = stream->fail();
+        }
+        else if (callback) {
+            callback(chunk);
+        }
+        else {
+            writeToDescriptor(chunk);
+        }
+    }
+
+    bool hasFailed() const {
+        return failed;
+    }
+
+private:
+    void writeToDescriptor(std::string_view chunk) {
+        while (not chunk.empty()) {
+            auto written = ::write(fd, chunk.data(), chunk.size());
+
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                failed = true;
+                return;
+            }
+
+            chunk.remove_prefix(written);
+        }
+    }
+
+    int fd {-1};
+    std::ostream* stream {nullptr};
+    Callback callback;
+    bool failed {false};
+};
+
 struct Console {
     static void write() {}
 
@@ -1,17 +1,38 @@
 #pragma once
 
+#include <cstdint>
+
+// A position in a source file: the file's id in the SourceManager and the 
+// byte offset into it. Lines and columns are worked out from the offset 
+// only when they are needed (see SourceManager::resolve).
 struct Location {
     Location() = default;
     Location(
-        const std::string& file,
-        size_t line,
-        size_t column
+        uint32_t fileId,
+        uint32_t offset
     ) : 
-        file(file),
-        line(line),
-        column(column) {}
+        fileId(fileId),
+        offset(offset) {}
+
+    uint32_t fileId {0};
+    uint32_t offset {0};
+};
+
+// The bytes [begin, end) of a file that a node was parsed from. Nodes that 
+// were made up rather than parsed have an empty range.
+struct SourceRange {
+    SourceRange() = default;
+    SourceRange(
+        uint32_t begin,
+        uint32_t end
+    ) :
+        begin(begin),
+        end(end) {}
+
+    bool isEmpty() const {
+        return end <= begin;
+    }
 
-    std::string file;
-    size_t line;
-    size_t column;
+    uint32_t begin {0};
+    uint32_t end {0};
 };
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+// Conversions between python numeric literals and their values. Nothing 
+// here allocates unless a literal is unusually long.
+
+enum class NumberStatus {
+    Ok,
+    OutOfRange, // a valid literal whose value does not fit
+    Invalid,
+};
+
+// Hands 'text' to 'parse' with its underscores taken out.
+template <typename ParseT>
+inline NumberStatus parseWithoutUnderscores(std::string_view text, ParseT parse) {
+    if (text.find('_') == std::string_view::npos) {
+        return parse(text);
+    }
+
+    char buffer[128];
+    std::string longText;
+    char* digits = buffer;
+
+    if (text.size() > sizeof(buffer)) {
+        longText.resize(text.size());
+        digits = longText.data();
+    }
+
+    size_t length = 0;
+
+    for (char c : text) {
+        if (c != '_') {
+            digits[length++] = c;
+        }
+    }
+
+    return parse(std::string_view(digits, length));
+}
+
+/**
+ * @brief      Works out the value of an integer literal: decimal, or hex, 
+ *             octal or binary with a 0x, 0o or 0b prefix.
+ *
+ * @param[in]  text   The literal as written.
+ * @param      value  The value; only set when the result is Ok.
+ *
+ * @return     OutOfRange when the value needs more than 63 bits.
+ */
+inline NumberStatus parseIntegerLiteral(std::string_view text, int64_t& value) {
+    int base = 10;
+
+    if ((text.size() > 2) && (text[0] == '0')) {
+        switch (text[1] | 0x20) {
+        case 'x': base = 16; break;
+        case 'o': base = 8;  break;
+        case 'b': base = 2;  break;
+        }
+
+        if (base != 10) {
+            text.remove_prefix(2);
+        }
+    }
+
+    return parseWithoutUnderscores(text, [&](std::string_view digits) {
+        auto end = digits.data() + digits.size();
+        auto [last, error] = std::from_chars(digits.data(), end, value, base);
+
+        if (error == std::errc::result_out_of_range) {
+            return NumberStatus::OutOfRange;
+        }
+
+        if ((error != std::errc()) || (last != end)) {
+            return NumberStatus::Invalid;
+        }
+
+        return NumberStatus::Ok;
+    });
+}
+
+/**
+ * @brief      Works out the value of a float or imaginary literal, the way 
+ *             python does: values too big become infinity and values too 
+ *             small become 0.
+ *
+ * @param[in]  text   The literal as written; a trailing 'j' is ignored.
+ * @param      value  The value.
+ *
+ * @return     Ok or Invalid.
+ */
+inline NumberStatus parseFloatLiteral(std::string_view text, double& value) {
+    if (not text.empty() && ((text.back() | 0x20) == 'j')) {
+        text.remove_suffix(1);
+    }
+
+    return parseWithoutUnderscores(text, [&](std::string_view digits) {
+        auto end = digits.data() + digits.size();
+        auto [last, error] = std::from_chars(digits.data(), end, value);
+
+        if (error == std::errc::result_out_of_range) {
+            // from_chars leaves the value alone here; strtod rounds it
+            std::string copy(digits);
+            value = std::strtod(copy.data(), nullptr);
+            return NumberStatus::Ok;
+        }
+
+        if ((error != std::errc()) || (last != end)) {
+            return NumberStatus::Invalid;
+        }
+
+        return NumberStatus::Ok;
+    });
+}
+
+// enough for any value formatted by the functions below
+constexpr size_t maxFormattedNumberLength = 32;
+
+inline std::string_view formatIntegerLiteral(char* buffer, int64_t value) {
+    auto result = std::to_chars(buffer, buffer + maxFormattedNumberLength, value);
+    return std::string_view(buffer, result.ptr - buffer);
+}
+
+/**
+ * @brief      Writes the shortest literal that reads back as 'value', in 
+ *             the shortest round-trip form of std::to_chars ("0.1", 
+ *             "1e+05", "2.0"). That is not always python's repr, which 
+ *             writes 1e5 as "100000.0", but it means the same.
+ *
+ * @param      buffer       At least maxFormattedNumberLength bytes.
+ * @param[in]  value        The value.
+ * @param[in]  isImaginary  Whether to add a 'j'.
+ *
+ * @return     The literal, in 'buffer'.
+ */
+inline std::string_view formatFloatLiteral(
+    char* buffer, 
+    double value, 
+    bool isImaginary
+) {
+    char* end = buffer;
+
+    if (std::isinf(value)) {
+        // only a literal too big for a double gets here
+        for (char c : std::string_view("1e999")) {
+            *end++ = c;
+        }
+    }
+    else {
+        end = std::to_chars(buffer, buffer + maxFormattedNumberLength, value).ptr;
+
+        // without a '.' or an exponent it would read back as an integer
+        if (
+            (not isImaginary) 
+            && (std::string_view(buffer, end - buffer).find_first_of(".e") 
+                == std::string_view::npos)
+        ) {
+            *end++ = '.';
+            *end++ = '0';
+        }
+    }
+
+    if (isImaginary) {
+        *end++ = 'j';
+    }
+
+    return std::string_view(buffer, end - buffer);
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "location.h"
+
+// A file known to the SourceManager. 'lineStarts' holds the offset at 
+// which every line seen so far begins; the lexer adds to it as it goes.
+struct SourceFile {
+    SourceFile(std::string name)
+        : name(std::move(name)) {}
+
+    std::string name;
+    std::vector<uint32_t> lineStarts {0};
+};
+
+struct ResolvedLocation {
+    const std::string& file;
+    size_t line;
+    size_t column;
+};
+
+/**
+ * @brief      Gives every source file a small integer id, so that locations 
+ *             do not need to carry the file's name. Id 0 stands for "no 
+ *             file". A file keeps its id when it is added again, so a 
+ *             long-lived process that reads the same files over and over 
+ *             does not grow. Files can be added from several threads at 
+ *             once.
+ */
+class SourceManager {
+public:
+    SourceManager() {
+        files.emplace_back("<unknown>");
+    }
+
+    SourceManager(const SourceManager&) = delete;
+
+    /**
+     * @brief      Registers a file. A file that is added again keeps its 
+     *  id and the line starts found so far, which another parse of it may 
+     *  still be reading. Only lines past the last known start are added 
+     *  to them, so two lexers must not read the same file's new lines at 
+     *  once; the driver never parses a file twice at the same time.
+     *
+     * @param[in]  name  The file name.
+     *
+     * @return     The id of the file.
+     */
+    uint32_t addFile(std::string name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = ids.find(name);
+
+        if (found != ids.end()) {
+            return found->second;
+        }
+
+        uint32_t id = files.size();
+        files.emplace_back(name);
+        ids.emplace(std::move(name), id);
+        return id;
+    }
+
+    // the returned reference stays valid for the manager's lifetime
+    SourceFile& getFile(uint32_t id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return files[id];
+    }
+
+    const std::string& getFileName(uint32_t id) {
+        return getFile(id).name;
+    }
+
+    /**
+     * @brief      Works out the line and column of a location.
+     *
+     * @param[in]  location  The location.
+     *
+     * @return     The file name, line and column; both count from 1, and 
+     *  columns count bytes.
+     */
+    ResolvedLocation resolve(const Location& location) {
+        auto& file = getFile(location.fileId);
+        auto& starts = file.lineStarts;
+
+        auto it = std::upper_bound(
+            std::begin(starts), 
+            std::end(starts), 
+            location.offset
+        );
+
+        size_t line = it - std::begin(starts);
+        size_t column = location.offset - *(it - 1) + 1;
+
+        return { file.name, line, column };
+    }
+
+private:
+    std::mutex mutex;
+    std::deque<SourceFile> files;
+    std::unordered_map<std::string, uint32_t> ids;
+};
+
+inline SourceManager& getSourceManager() {
+    static SourceManager sourceManager;
+    return sourceManager;
+}
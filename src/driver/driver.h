@@ -0,0 +1,473 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "threadpool.h"
+
+// One parsed source file. The statements live in the module's own arena, 
+// so a module can be handed to another thread or dropped on its own. 
+// 'loaded' is set once the whole file has been parsed.
+struct Module {
+    std::string fileName;
+    Arena arena;
+    std::vector<StmtPtr> statements;
+    bool loaded {false};
+};
+
+/**
+ * @brief      Expands a list of paths into the python files to parse. 
+ *             Directories are searched recursively for '.py' files, in 
+ *             sorted order; other paths are taken as they are. A file 
+ *             named more than once, as a path or through a directory, is 
+ *             kept where it first comes, so that no two parses of it run 
+ *             at once.
+ *
+ * @param[in]  paths        The paths.
+ * @param      diagnostics  Where to report directories that could not be 
+ *  searched.
+ *
+ * @return     The file names.
+ */
+std::vector<std::string> collectSourceFiles(
+    const std::vector<std::string>& paths,
+    Diagnostics& diagnostics
+) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> files;
+    std::unordered_set<std::string> seen;
+
+    // keeps 'file' unless it is one already kept under another name
+    auto addFile = [&](const std::string& file) {
+        std::error_code error;
+        auto canonical = fs::weakly_canonical(file, error);
+        auto key = error ? file : canonical.string();
+
+        if (seen.insert(std::move(key)).second) {
+            files.push_back(file);
+        }
+    };
+
+    for (const auto& path : paths) {
+        std::error_code error;
+
+        if (not fs::is_directory(path, error)) {
+            addFile(path);
+            continue;
+        }
+
+        std::vector<std::string> found;
+        auto options = fs::directory_options::skip_permission_denied;
+
+        for (
+            fs::recursive_directory_iterator it(path, options, error), end; 
+            not error && it != end; 
+            it.increment(error)
+        ) {
+            if (it->is_regular_file(error) && it->path().extension() == ".py") {
+                found.push_back(it->path().string());
+            }
+        }
+
+        if (error) {
+            diagnostics.reportWarning(
+                "could not search '" + path + "': " + error.message()
+            );
+        }
+
+        std::sort(std::begin(found), std::end(found));
+
+        for (const auto& file : found) {
+            addFile(file);
+        }
+    }
+
+    return files;
+}
+
+/**
+ * @brief      Parses one file into a module. Syntax errors are recovered 
+ *             from, statement by statement.
+ *
+ * @param      module       The module; its file name must be set.
+ * @param      diagnostics  Where to report problems with the file.
+ */
+void parseModule(Module& module, Diagnostics& diagnostics) {
+    Lexer lexer(&diagnostics);
+
+    if (not lexer.useFile(module.fileName)) {
+        diagnostics.reportError("could not open '" + module.fileName + "'");
+        return;
+    }
+
+    try {
+        Parser parser(&lexer, &module.arena, &diagnostics);
+        parser.enableErrorRecovery();
+        parser.parseStmtList(module.statements);
+        module.loaded = true;
+    }
+    catch (const FatalError&) {}
+}
+
+/**
+ * @brief      Parses one file into a module on a thread pool. The file is 
+ *             cut at top-level statements (see Lexer::findSplitPoints) into 
+ *             a few parts per thread, and each part is parsed by a lexer 
+ *             and a parser of its own, into an arena of its own. The 
+ *             module's arena then takes over the parts' arenas, and their 
+ *             statements and diagnostics are put together in order. For a 
+ *             file without syntax errors the statements are the same as 
+ *             those of parseModule(). Must not be called from one of the 
+ *             pool's threads.
+ *
+ * @param      module       The module; its file name must be set.
+ * @param      diagnostics  Where to report problems with the file.
+ * @param      pool         The pool to run on.
+ */
+void parseModuleInParts(
+    Module& module, 
+    Diagnostics& diagnostics, 
+    ThreadPool& pool
+) {
+    // below this a part is not worth a task of its own
+    constexpr size_t minimumPartSize = 64 * 1024;
+
+    struct Part {
+        Lexer::SplitPoint begin;
+        size_t end;
+        Arena arena;
+        std::vector<StmtPtr> statements;
+        Diagnostics diagnostics;
+        bool loaded {false};
+    };
+
+    Lexer lexer(&diagnostics);
+
+    if (not lexer.useFile(module.fileName)) {
+        diagnostics.reportError("could not open '" + module.fileName + "'");
+        return;
+    }
+
+    // a few parts per thread, so that a slow part can be made up for
+    auto size = lexer.getSource().size();
+    auto distance = std::max(size / (pool.size() * 4), minimumPartSize);
+    uint64_t firstIndentation;
+    auto points = lexer.findSplitPoints(distance, firstIndentation);
+
+    std::vector<Part> parts(points.size() + 1);
+    parts[0].begin = { 0, 1 };
+
+    for (size_t i = 0; i < points.size(); ++i) {
+        parts[i].end = points[i].offset;
+        parts[i + 1].begin = points[i];
+    }
+
+    parts.back().end = size;
+
+    for (size_t i = 0; i < parts.size(); ++i) {
+        pool.submit([&lexer, &parts, i, firstIndentation] {
+            auto& part = parts[i];
+            Lexer partLexer(&part.diagnostics);
+            partLexer.usePartOf(lexer, part.begin, part.end);
+
+            try {
+                Parser parser(&partLexer, &part.arena, &part.diagnostics);
+                parser.enableErrorRecovery();
+
+                // the first block of the file may be in an earlier part
+                if (i != 0) {
+                    parser.setIndentationScheme(firstIndentation);
+                }
+
+                parser.parseStmtList(part.statements);
+                part.loaded = true;
+            }
+            catch (const FatalError&) {}
+        });
+    }
+
+    pool.wait();
+
+    module.loaded = true;
+
+    for (auto& part : parts) {
+        module.arena.adopt(part.arena);
+        module.statements.insert(
+            std::end(module.statements), 
+            std::begin(part.statements), 
+            std::end(part.statements)
+        );
+        diagnostics.append(std::move(part.diagnostics));
+        module.loaded = module.loaded && part.loaded;
+    }
+}
+
+/**
+ * @brief      Parses every file on a thread pool, one task per file. The 
+ *             biggest files are queued first so that a large file found 
+ *             late does not hold up the end of the run. A single file is 
+ *             parsed in parts instead, by parseModuleInParts().
+ *
+ * @param[in]  files        The file names.
+ * @param      session      Gets the diagnostics of every file.
+ * @param[in]  threadCount  The number of worker threads.
+ *
+ * @return     One module per file, in the same order as the files.
+ */
+std::vector<Module> parseModules(
+    const std::vector<std::string>& files,
+    DiagnosticSession& session,
+    size_t threadCount = ThreadPool::defaultThreadCount()
+) {
+    std::vector<Module> modules(files.size());
+    std::vector<uintmax_t> sizes(files.size());
+
+    for (size_t i = 0; i < files.size(); ++i) {
+        std::error_code error;
+        modules[i].fileName = files[i];
+        sizes[i] = std::filesystem::file_size(files[i], error);
+
+        if (error) {
+            sizes[i] = 0;
+        }
+    }
+
+    // a single file would keep a single thread busy; cut it up instead
+    if (files.size() == 1) {
+        ThreadPool pool(threadCount);
+        Diagnostics diagnostics;
+        parseModuleInParts(modules[0], diagnostics, pool);
+        session.publish(modules[0].fileName, std::move(diagnostics));
+        return modules;
+    }
+
+    std::vector<size_t> order(files.size());
+    std::iota(std::begin(order), std::end(order), 0);
+    std::stable_sort(std::begin(order), std::end(order), [&](auto a, auto b) {
+        return sizes[a] > sizes[b];
+    });
+
+    ThreadPool pool(std::min(threadCount, std::max<size_t>(files.size(), 1)));
+
+    for (auto index : order) {
+        pool.submit([&modules, &session, index] {
+            Diagnostics diagnostics;
+            parseModule(modules[index], diagnostics);
+            session.publish(modules[index].fileName, std::move(diagnostics));
+        });
+    }
+
+    pool.wait();
+    return modules;
+}
+
+// Asks every function for its body, nested ones too, so that a lazy parse 
+// has parsed them all. Expressions hold no function bodies and are not 
+// walked.
+class FunctionBodyParser : public AstWalker<FunctionBodyParser> {
+public:
+    void visitExpr(Expr&) {}
+};
+
+/**
+ * @brief      Parses every function body that a lazy parse left for later. 
+ *             Bodies share the lexer and the arena of the parse that 
+ *             skipped them, so they must all be parsed on one thread before 
+ *             the statements are handed to others.
+ *
+ * @param      statements  The statements.
+ */
+void parseAllBodies(const std::vector<StmtPtr>& statements) {
+    FunctionBodyParser parser;
+
+    for (auto stmt : statements) {
+        parser.visitStmt(*stmt);
+    }
+}
+
+/**
+ * @brief      Transforms top-level statements back to source on a thread 
+ *             pool. The statements are cut into runs of about the same 
+ *             amount of source, each run is transformed into a buffer of 
+ *             its own, and every buffer is written to the sink as soon as 
+ *             it and the ones before it are done. Only a few runs per 
+ *             thread are under way or waiting to be written at a time, and 
+ *             runs are kept small, so the output never sits in memory all 
+ *             at once. The output is the same as that of a single 
+ *             transformer that is given every statement in turn. Must not 
+ *             be called from a task of the pool.
+ *
+ * @param[in]  statements  The statements, in order. Function bodies a 
+ *  lazy parse left for later are parsed first, on this thread.
+ * @param      sink        Where the output goes.
+ * @param      pool        The pool to run on.
+ * @param[in]  minify      Whether to emit minified output.
+ * @param      sourceMap   If given, gets mappings for the output, with 
+ *  offsets counted from the start of it.
+ * @param[in]  originalSource  If given, the text the statements were 
+ *  parsed from; what is not dirty is copied from it, as 
+ *  PythonAstTransformer::setOriginalSource() describes. It must outlive 
+ *  the call.
+ */
+void transformModule(
+    const std::vector<StmtPtr>& statements,
+    OutputSink& sink,
+    ThreadPool& pool,
+    bool minify = false,
+    SourceMap* sourceMap = nullptr,
+    std::string_view originalSource = {}
+) {
+    // a lazy body moves the lexer it shares with the others when parsed
+    parseAllBodies(statements);
+
+    if (statements.empty()) {
+        return;
+    }
+
+    struct Piece {
+        size_t begin;
+        size_t end;
+        std::string output;
+        SourceMap sourceMap;
+        bool done;
+        std::exception_ptr exception;
+    };
+
+    // the most source a piece takes, which bounds what it holds until it 
+    // is written
+    constexpr uint64_t maxPieceSize = 1 << 20;
+
+    std::vector<Piece> pieces;
+
+    // a few pieces per thread, so that a slow piece can be made up for
+    auto wanted = std::min(statements.size(), pool.size() * 4);
+    auto first = statements.front()->location.offset;
+    auto last = statements.back()->location.offset;
+    auto total = (last > first) ? (last - first) : 0;
+    auto target = std::clamp<uint64_t>(total / wanted, 1, maxPieceSize);
+
+    size_t begin = 0;
+
+    for (size_t i = 1; i < statements.size(); ++i) {
+        auto size = statements[i]->location.offset 
+            - statements[begin]->location.offset;
+
+        if (size >= target) {
+            pieces.push_back({ begin, i, {}, {}, false, nullptr });
+            begin = i;
+        }
+    }
+
+    pieces.push_back({ begin, statements.size(), {}, {}, false, nullptr });
+
+    std::mutex mutex;
+    std::condition_variable pieceDone;
+
+    auto transformPiece = [&statements, minify, sourceMap, originalSource](
+        Piece& piece
+    ) {
+        PythonAstTransformer transformer;
+        transformer.setOriginalSource(originalSource);
+
+        if (minify) {
+            transformer.enableMinifiedOutput();
+        }
+
+        if (sourceMap) {
+            transformer.setSourceMap(&piece.sourceMap);
+        }
+
+        // the source from the piece's first statement to the next one
+        auto sourceBegin = statements[piece.begin]->range.begin;
+        auto sourceEnd = (piece.end < statements.size())
+            ? statements[piece.end]->range.begin
+            : statements.back()->range.end;
+
+        if (sourceEnd > sourceBegin) {
+            transformer.reserveForSource(sourceEnd - sourceBegin);
+        }
+
+        if (piece.begin != 0) {
+            transformer.continueAfter(statements[piece.begin - 1]);
+        }
+
+        for (auto i = piece.begin; i < piece.end; ++i) {
+            transformer.appendStmt(statements[i]);
+        }
+
+        // the last piece ends the output as a flush would
+        if (piece.end == statements.size()) {
+            transformer.flush();
+        }
+
+        piece.output = transformer.takeBuffer();
+    };
+
+    auto submitPiece = [&](Piece& piece) {
+        pool.submit([&piece, &mutex, &pieceDone, transformPiece] {
+            std::exception_ptr exception;
+
+            try {
+                transformPiece(piece);
+            }
+            catch (...) {
+                exception = std::current_exception();
+            }
+
+            // notified under the lock, since the waiting thread may return 
+            // and take 'pieceDone' with it as soon as it can lock
+            std::lock_guard<std::mutex> lock(mutex);
+            piece.exception = exception;
+            piece.done = true;
+            pieceDone.notify_all();
+        });
+    };
+
+    // the pieces under way or waiting to be written at most
+    auto window = pool.size() * 2;
+    size_t submitted = 0;
+    uint64_t written = 0;
+
+    for (size_t next = 0; next < pieces.size(); ++next) {
+        while ((submitted < pieces.size()) && (submitted < next + window)) {
+            submitPiece(pieces[submitted++]);
+        }
+
+        auto& piece = pieces[next];
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            pieceDone.wait(lock, [&piece] { return piece.done; });
+
+            if (piece.exception) {
+                // the pieces still under way refer to this frame
+                pieceDone.wait(lock, [&] {
+                    return std::all_of(
+                        std::begin(pieces) + next, 
+                        std::begin(pieces) + submitted, 
+                        [](const Piece& other) { return other.done; }
+                    );
+                });
+                std::rethrow_exception(piece.exception);
+            }
+        }
+
+        if (sourceMap) {
+            sourceMap->append(piece.sourceMap, written);
+        }
+
+        sink.write(piece.output);
+        written += piece.output.size();
+
+        piece.output = std::string();
+        piece.sourceMap = SourceMap();
+    }
+}
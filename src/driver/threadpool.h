@@ -0,0 +1,191 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief      A fixed set of worker threads, each with its own task queue. 
+ *             A worker runs its own tasks newest first and, when it runs 
+ *             out, steals the oldest task from another worker's queue.
+ */
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit ThreadPool(size_t threadCount = defaultThreadCount()) {
+        if (threadCount == 0) {
+            threadCount = 1;
+        }
+
+        for (size_t i = 0; i < threadCount; ++i) {
+            queues.push_back(std::make_unique<WorkQueue>());
+        }
+
+        for (size_t i = 0; i < threadCount; ++i) {
+            threads.emplace_back([this, i] { run(i); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            stopping = true;
+        }
+
+        workAvailable.notify_all();
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    static size_t defaultThreadCount() {
+        auto count = std::thread::hardware_concurrency();
+        return count > 0 ? count : 1;
+    }
+
+    size_t size() const {
+        return threads.size();
+    }
+
+    /**
+     * @brief      Queues a task. Tasks queued from inside a worker go to 
+     *  that worker's own queue; others are spread over all the queues.
+     *
+     * @param[in]  task  The task.
+     */
+    void submit(Task task) {
+        size_t index;
+
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            index = (currentPool == this) 
+                ? currentWorker 
+                : (nextQueue++ % queues.size());
+            pendingTasks++;
+            queuedTasks++;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(queues[index]->mutex);
+            queues[index]->tasks.push_back(std::move(task));
+        }
+
+        workAvailable.notify_one();
+    }
+
+    /**
+     * @brief      Blocks until every task submitted so far has finished. If 
+     *  a task threw, the first exception is rethrown here.
+     */
+    void wait() {
+        std::unique_lock<std::mutex> lock(stateMutex);
+        allDone.wait(lock, [this] { return pendingTasks == 0; });
+
+        if (firstException) {
+            std::rethrow_exception(std::exchange(firstException, nullptr));
+        }
+    }
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool takeTask(size_t index, Task& task) {
+        {
+            auto& own = *queues[index];
+            std::lock_guard<std::mutex> lock(own.mutex);
+
+            if (not own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+
+        for (size_t i = 1; i < queues.size(); ++i) {
+            auto& victim = *queues[(index + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+
+            if (not victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void run(size_t index) {
+        currentPool = this;
+        currentWorker = index;
+
+        while (1) {
+            {
+                std::unique_lock<std::mutex> lock(stateMutex);
+                workAvailable.wait(lock, [this] {
+                    return stopping || (queuedTasks > 0);
+                });
+
+                if (queuedTasks == 0) {
+                    return;
+                }
+            }
+
+            Task task;
+
+            if (not takeTask(index, task)) {
+                // another worker got there first
+                std::this_thread::yield();
+                continue;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                queuedTasks--;
+            }
+
+            try {
+                task();
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                if (not firstException) {
+                    firstException = std::current_exception();
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(stateMutex);
+            if (--pendingTasks == 0) {
+                allDone.notify_all();
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> threads;
+
+    std::mutex stateMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+
+    size_t pendingTasks {0}; // submitted, not yet finished
+    size_t queuedTasks {0};  // submitted, not yet taken by a worker
+    size_t nextQueue {0};
+    bool stopping {false};
+    std::exception_ptr firstException;
+
+    static inline thread_local ThreadPool* currentPool {nullptr};
+    static inline thread_local size_t currentWorker {0};
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cwctype>
+
+// Classification of single bytes, used by the lexer to scan ASCII without 
+// decoding utf8 or calling into the locale. Bytes >= 0x80 have no class; 
+// the lexer decodes the full codepoint and falls back to the <cwctype> 
+// functions for those.
+enum CharacterClass : uint8_t {
+    CharacterClassSpace     = 1 << 0,
+    CharacterClassNewline   = 1 << 1,
+    CharacterClassDigit     = 1 << 2,
+    CharacterClassNameStart = 1 << 3,
+    CharacterClassName      = 1 << 4,
+};
+
+constexpr std::array<uint8_t, 256> makeCharacterClassTable() {
+    std::array<uint8_t, 256> table {};
+
+    for (int c = 0; c < 0x80; ++c) {
+        uint8_t value = 0;
+
+        if ((c == ' ') || ((c >= '\t') && (c <= '\r'))) {
+            value |= CharacterClassSpace;
+        }
+
+        if (c == '\n') {
+            value |= CharacterClassNewline;
+        }
+
+        if ((c >= '0') && (c <= '9')) {
+            value |= CharacterClassDigit | CharacterClassName;
+        }
+
+        if (
+            ((c >= 'a') && (c <= 'z'))
+            || ((c >= 'A') && (c <= 'Z'))
+            || (c == '_')
+        ) {
+            value |= CharacterClassNameStart | CharacterClassName;
+        }
+
+        table[c] = value;
+    }
+
+    return table;
+}
+
+constexpr std::array<uint8_t, 256> characterClassTable = 
+    makeCharacterClassTable();
+
+inline bool hasCharacterClass(unsigned char byte, uint8_t characterClass) {
+    return (characterClassTable[byte] & characterClass) != 0;
+}
+
+inline bool isSpaceCharacter(uint32_t value) {
+    if (value < 0x80) {
+        return hasCharacterClass(value, CharacterClassSpace);
+    }
+    return iswspace(value);
+}
+
+inline bool isDigitCharacter(uint32_t value) {
+    if (value < 0x80) {
+        return hasCharacterClass(value, CharacterClassDigit);
+    }
+    return iswdigit(value);
+}
+
+inline bool isNameStartCharacter(uint32_t value) {
+    if (value < 0x80) {
+        return hasCharacterClass(value, CharacterClassNameStart);
+    }
+    return iswalpha(value);
+}
+
+inline bool isNameCharacter(uint32_t value) {
+    if (value < 0x80) {
+        return hasCharacterClass(value, CharacterClassName);
+    }
+    return iswalnum(value);
+}
@@ -1,19 +1,27 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <cstddef>
 #include <vector>
 
+#include "charclass.h"
 #include "reader.h"
+#include "scan.h"
 #include "token.cpp"
 
 class Lexer {
 public:
-    Lexer() = default;
+    // problems with the input are reported to 'diagnostics'
+    explicit Lexer(Diagnostics* diagnostics)
+        : diagnostics(diagnostics) {}
+
     ~Lexer() {}
 
     /**
-     * @brief      Prepares the lexer to use the given file.
+     * @brief      Prepares the lexer to use the given file. The file is 
+     *  memory-mapped where possible; "-" reads the standard input. Files of 
+     *  4 GiB or more are refused, since locations hold 32-bit offsets.
      *
      * @param[in]  fileName  The file name.
      *
@@ -25,6 +33,17 @@ public:
             return false;
         }
 
+        if (reader.getData().size() > UINT32_MAX) {
+            diagnostics->reportError(
+                "'" + reader.getFileName() + "' is too big; files of 4 GiB "
+                "or more are not supported"
+            );
+            return false;
+        }
+
+        fileId = getSourceManager().addFile(reader.getFileName());
+        sourceFile = &getSourceManager().getFile(fileId);
+
         currentLineNumber = 1;
         currentColumnNumber = 0;
 
@@ -42,49 +61,397 @@ public:
     }
 
     /**
-     * @brief      Reads a token.
+     * @brief      Gets the id under which the current file was registered 
+     *  with the SourceManager.
      *
-     * @param      token  where to put details of the token.
+     * @return     The file id.
      */
-    void readToken(Token& token) {
-        token.clear();
+    inline uint32_t getFileId() const {
+        return fileId;
+    }
 
-        while (iswspace(currentCharacter)) {
-            if (matchCharacter('\n')) {
-                token.virtualOffset = 0;
-                currentLineNumber++;
-                currentColumnNumber = 0;
+    /**
+     * @brief      Gets the whole of the current file.
+     *
+     * @return     The file's contents.
+     */
+    inline std::string_view getSource() const {
+        return reader.getData();
+    }
+
+    // A place to cut the file at: the start of a line, and its number.
+    struct SplitPoint {
+        size_t offset;
+        size_t lineNumber;
+    };
+
+    /**
+     * @brief      Prepares the lexer to read part of the file another lexer 
+     *  uses, under the same file id; the other lexer must outlive this one. 
+     *  The part must start at the start of a line, and findSplitPoints() 
+     *  must have been called on the other lexer, so that every line start 
+     *  of the file is known and lexers can read parts of it side by side.
+     *
+     * @param[in]  other      The lexer that opened the file.
+     * @param[in]  begin      Where the part starts.
+     * @param[in]  endOffset  Where the part ends; reading stops there as 
+     *  if the file ended.
+     */
+    void usePartOf(const Lexer& other, SplitPoint begin, size_t endOffset) {
+        reader.shareSource(other.reader);
+        reader.skipTo(reader.getData().data() + begin.offset);
+        reader.setEnd(reader.getData().data() + endOffset);
+
+        fileId = other.fileId;
+        sourceFile = other.sourceFile;
+
+        currentLineNumber = begin.lineNumber;
+        currentColumnNumber = 0;
+
+        fetchNextCharacter();
+    }
+
+    /**
+     * @brief      Finds where the file can be cut into parts that parse on 
+     *  their own: the starts of lines, outside brackets and strings, that 
+     *  begin a top-level statement at column 1. Lines that go on with the 
+     *  statement before them ("elif", "else", "except", "finally") and ones 
+     *  after a decorator are left out. Every line start of the file is 
+     *  recorded on the way.
+     *
+     * @param[in]  minimumDistance   The least number of bytes from the start 
+     *  of the file or the last place found to the next.
+     * @param[out] firstIndentation  The indentation of the file's first 
+     *  indented line outside brackets and strings, or 0; the first block 
+     *  of the file sets the indentation scheme with it.
+     *
+     * @return     The places found, in order.
+     */
+    std::vector<SplitPoint> findSplitPoints(
+        size_t minimumDistance, 
+        uint64_t& firstIndentation
+    ) {
+        const char* const data = reader.getData().data();
+        const char* const end = reader.getEnd();
+
+        std::vector<SplitPoint> points;
+        size_t lastPoint = 0;
+        bool followsDecorator = false;
+        size_t contentEnd = 0;
+
+        BlockScan scan;
+        scan.position = data;
+        scan.lineNumber = 1;
+        scan.lineStart = data;
+
+        firstIndentation = 0;
+
+        while ((scan.position != end) && (*scan.position != '\0')) {
+            uint64_t width = 0;
+            auto position = skipIndentation(scan.position, end, width);
+
+            if (position && (position != end) && (*position == '#')) {
+                scan.position = findNewline(position, end);
             }
-            else if (matchCharacter('\t')) {
-                token.virtualOffset += 4;
+            else if (position && (position != end) && (*position != '\n')) {
+                size_t offset = scan.position - data;
+
+                if (width != 0) {
+                    if (firstIndentation == 0) {
+                        firstIndentation = width;
+                    }
+                }
+                else if (*position == '@') {
+                    followsDecorator = true;
+                }
+                else {
+                    if (
+                        (offset - lastPoint >= minimumDistance) 
+                        && not followsDecorator
+                        && not startsClause(position, end)
+                    ) {
+                        points.push_back({ offset, scan.lineNumber });
+                        lastPoint = offset;
+                    }
+                    followsDecorator = false;
+                }
+
+                scan.position = position;
+                skipLogicalLine(scan, end, contentEnd);
+            }
+            else if (position == nullptr) {
+                // a non-ascii byte before the first token; not a place to 
+                // cut
+                skipLogicalLine(scan, end, contentEnd);
             }
             else {
-                token.virtualOffset += 1;
+                scan.position = position;
             }
-            fetchNextCharacter();
+
+            if ((scan.position != end) && (*scan.position == '\n')) {
+                passLineBreak(scan);
+            }
+        }
+
+        return points;
+    }
+
+    /**
+     * @brief      Goes back to the start of a token read before, to read the 
+     *  text that skipBlock() stepped over after it. The source is taken to 
+     *  end with that text, so that the tokens after it are not read twice.
+     *
+     * @param[in]  offset        The token's offset.
+     * @param[in]  lineNumber    The token's line number.
+     * @param[in]  columnNumber  The token's column number.
+     * @param[in]  endOffset     Where the text stepped over ends.
+     */
+    void seek(
+        size_t offset, 
+        size_t lineNumber, 
+        size_t columnNumber, 
+        size_t endOffset
+    ) {
+        reader.skipTo(reader.getData().data() + offset);
+        reader.setEnd(reader.getData().data() + endOffset);
+        hasPendingToken = false;
+
+        currentLineNumber = lineNumber;
+        currentColumnNumber = columnNumber - 1;
+
+        fetchNextCharacter();
+    }
+
+    // What skipBlock() stepped over.
+    struct SkippedBlock {
+        uint64_t indentation; // of its first line
+        size_t contentEnd;    // the offset after its last token but ';'s
+                              // (or after the ':', if it has none)
+        size_t endOffset;     // that of the first token after it
+    };
+
+    /**
+     * @brief      Steps over the block after the ':' just read without 
+     *  making tokens of it: the rest of the ':' line, then every line up to 
+     *  the first one, outside brackets and strings, that is indented no 
+     *  deeper than 'indentation'. Only quotes, brackets, comments and line 
+     *  breaks are looked at. The next token read is the first one after the 
+     *  block.
+     *
+     * @param[in]  indentation       The indentation of the line with the 
+     *  ':'.
+     * @param[in]  blockIndentation  The indentation the block's first line 
+     *  must have, or 0 for any deeper than 'indentation'.
+     * @param[out] block             Where to put what was stepped over.
+     *
+     * @return     Whether the block was stepped over. Nothing is read when 
+     *  the ':' is followed by more than a comment on its line, the block is 
+     *  not indented as asked, or its indentation holds a non-ascii byte; 
+     *  reading the tokens is left to say what is wrong there.
+     */
+    bool skipBlock(
+        uint64_t indentation, 
+        uint64_t blockIndentation, 
+        SkippedBlock& block
+    ) {
+        if (hasPendingToken || fileEnded()) {
+            return false;
+        }
+
+        const char* const data = reader.getData().data();
+        const char* const end = reader.getEnd();
+
+        uint64_t width = 0;
+        BlockScan scan;
+        scan.position = currentPosition;
+        scan.lineNumber = currentLineNumber;
+        scan.lineStart = currentPosition;
+
+        while ((scan.lineStart != data) && (scan.lineStart[-1] != '\n')) {
+            scan.lineStart--;
+        }
+
+        scan.position = skipIndentation(scan.position, end, width);
+
+        if (scan.position == nullptr) {
+            return false;
+        }
+
+        if ((scan.position != end) && (*scan.position == '#')) {
+            scan.position = findNewline(scan.position, end);
+        }
+
+        if ((scan.position == end) || (*scan.position != '\n')) {
+            return false;
+        }
+
+        block.indentation = 0;
+        block.contentEnd = currentPosition - data;
+        block.endOffset = 0;
+
+        const char* lineBreak; // the one before the line looked at
+
+        while (1) {
+            lineBreak = scan.position;
+            passLineBreak(scan);
+
+            width = 0;
+            scan.position = skipIndentation(scan.position, end, width);
+
+            if (scan.position == nullptr) {
+                return false;
+            }
+
+            if ((scan.position == end) || (*scan.position == '\0')) {
+                break;
+            }
+
+            if (*scan.position == '\n') {
+                continue;
+            }
+
+            if (*scan.position == '#') {
+                scan.position = findNewline(scan.position, end);
+
+                if (scan.position == end) {
+                    break;
+                }
+                continue;
+            }
+
+            if (block.indentation == 0) {
+                if (
+                    (width <= indentation)
+                    || (
+                        (blockIndentation != 0) 
+                        && (width != blockIndentation)
+                    )
+                ) {
+                    return false;
+                }
+                block.indentation = width;
+            }
+            else if (width <= indentation) {
+                block.endOffset = scan.position - data;
+
+                // the line break before this line is read as usual
+                scan.position = lineBreak;
+                scan.lineNumber--;
+                scan.lineStart = scan.previousLineStart;
+                break;
+            }
+
+            skipLogicalLine(scan, end, block.contentEnd);
+
+            if ((scan.position == end) || (*scan.position == '\0')) {
+                break;
+            }
+        }
+
+        if (block.indentation == 0) {
+            return false;
+        }
+
+        if (block.endOffset == 0) {
+            block.endOffset = scan.position - data;
+        }
+
+        currentLineNumber = scan.lineNumber;
+        currentColumnNumber = countCharacters(scan.lineStart, scan.position);
+        reader.skipTo(scan.position);
+        fetchNextCharacter();
+
+        return true;
+    }
+
+    /**
+     * @brief      Reads a token. "not in" and "is not" come out as single 
+     *  tokens, which takes reading the token after a "not" or an "is" 
+     *  ahead of time.
+     *
+     * @param      token  where to put details of the token.
+     */
+    void readToken(Token& token) {
+        if (hasPendingToken) {
+            token = std::move(pendingToken);
+            hasPendingToken = false;
+        }
+        else {
+            readSingleToken(token);
+        }
+
+        TokenKind secondKind;
+        TokenKind fusedKind;
+
+        if (token.kind == TokenKind::ConditionalNot) {
+            secondKind = TokenKind::RelationalIsContainedIn;
+            fusedKind = TokenKind::RelationalIsNotContainedIn;
+        }
+        else if (token.kind == TokenKind::RelationalIdentical) {
+            secondKind = TokenKind::ConditionalNot;
+            fusedKind = TokenKind::RelationalNotIdentical;
+        }
+        else {
+            return;
+        }
+
+        readSingleToken(pendingToken);
+
+        if (pendingToken.kind != secondKind) {
+            hasPendingToken = true;
+            return;
+        }
+
+        token.kind = fusedKind;
+        token.setValue(toString(fusedKind));
+        token.length = pendingToken.offset + pendingToken.length - token.offset;
+    }
+
+private:
+    void readSingleToken(Token& token) {
+        token.clear();
+        skipWhitespace(token);
+
+        while (matchCharacter('#')) {
+            skipInlineComment();
+            skipWhitespace(token);
         }
 
         token.lineNumber = currentLineNumber;
         token.columnNumber = currentColumnNumber;
         token.kind = TokenKind::None;
 
+        const char* tokenStart = currentPosition;
+        token.offset = tokenStart - reader.getData().data();
+
         if (fileEnded()) {
             token.kind = TokenKind::EndOfFile;
-            token.value = toString(TokenKind::EndOfFile);
+            token.setValue(toString(TokenKind::EndOfFile));
+            token.length = 0;
             token.virtualOffset = 0;
             return;
         }
 
+        readTokenText(token);
+
+        token.length = currentPosition - tokenStart;
+
+        if (not token.isDecoded()) {
+            token.setValue(std::string_view(tokenStart, token.length));
+        }
+    }
+
+    void readTokenText(Token& token) {
         #define LEX_CASE_1(ch, ifchar) \
             case ch: {\
-                appendCharacterAndFetchNext(currentCharacter, token);\
+                fetchNextCharacter();\
                 token.kind = ifchar;\
                 return;\
             }
 
         #define LEX_CASE_2(char1, char2, ifchar1, ifchar12) \
             case char1: {\
-                appendCharacterAndFetchNext(currentCharacter, token);\
+                fetchNextCharacter();\
 \
                 if (not matchCharacter(char2)) {\
                     token.kind = ifchar1;\
@@ -92,7 +459,7 @@ public:
                 }\
 \
                 token.kind = ifchar12;\
-                appendCharacterAndFetchNext(currentCharacter, token);\
+                fetchNextCharacter();\
 \
                 return;\
             }
@@ -112,7 +479,16 @@ public:
         LEX_CASE_1(',', TokenKind::Comma)
 
         LEX_CASE_1('~', TokenKind::LogicalNot)
-        LEX_CASE_1('.', TokenKind::Access)
+        case '.': {
+            if (isDigitCharacter(reader.peekByte())) {
+                readNumber(token);
+                return;
+            }
+
+            fetchNextCharacter();
+            token.kind = TokenKind::Access;
+            return;
+        }
         
         LEX_CASE_2('@', '=', 
             TokenKind::At, 
@@ -143,14 +519,14 @@ public:
             TokenKind::AssignmentLogicalAnd)
 
         case '*': {
-            appendCharacterAndFetchNext(currentCharacter, token);
+            fetchNextCharacter();
 
             switch (currentCharacter) {
             case '*': {
-                appendCharacterAndFetchNext(currentCharacter, token);
+                fetchNextCharacter();
 
                 if (matchCharacter('=')) {
-                    appendCharacterAndFetchNext(currentCharacter, token);
+                    fetchNextCharacter();
                     token.kind = 
                         TokenKind::AssignmentArithmeticPow;
                     return;
@@ -160,7 +536,7 @@ public:
                 return;
             }
             case '=': {
-                appendCharacterAndFetchNext(currentCharacter, token);
+                fetchNextCharacter();
                 token.kind = 
                     TokenKind::AssignmentArithmeticMul;
                 return;
@@ -172,21 +548,15 @@ public:
             return;
         } 
 
-        case '#': {
-            fetchNextCharacter();
-            skipInlineComment();
-            readToken(token);
-            return;
-        }
         case '/': {
-            appendCharacterAndFetchNext(currentCharacter, token);
+            fetchNextCharacter();
 
             switch (currentCharacter) {
             case '/': {
-                appendCharacterAndFetchNext(currentCharacter, token);
+                fetchNextCharacter();
 
                 if (matchCharacter('=')) {
-                    appendCharacterAndFetchNext(currentCharacter, token);
+                    fetchNextCharacter();
                     token.kind = 
                         TokenKind::AssignmentArithmeticFloorDiv;
                     return;
@@ -196,7 +566,7 @@ public:
                 return;
             }
             case '=': {
-                appendCharacterAndFetchNext(currentCharacter, token);
+                fetchNextCharacter();
                 token.kind = TokenKind::AssignmentArithmeticDiv;
                 return;
             }
@@ -207,10 +577,10 @@ public:
             return;
         }
         case '=': {
-            appendCharacterAndFetchNext(currentCharacter, token);
+            fetchNextCharacter();
 
             if (matchCharacter('=')) {
-                appendCharacterAndFetchNext(currentCharacter, token);
+                fetchNextCharacter();
                 token.kind = TokenKind::RelationalEquals;
             }
             else {
@@ -220,16 +590,16 @@ public:
             return;
         }
         case '-': {
-            appendCharacterAndFetchNext(currentCharacter, token);
+            fetchNextCharacter();
 
             switch (currentCharacter) {
             case '=': {
-                appendCharacterAndFetchNext(currentCharacter, token);
+                fetchNextCharacter();
                 token.kind = TokenKind::AssignmentArithmeticSub;
                 return;
             }
             case '>': {
-                appendCharacterAndFetchNext(currentCharacter, token);
+                fetchNextCharacter();
                 token.kind = TokenKind::SingleArrow;
                 return;
             }
@@ -240,19 +610,19 @@ public:
             return;
         }
         case '<': {
-            appendCharacterAndFetchNext(currentCharacter, token);
+            fetchNextCharacter();
 
             switch (currentCharacter) {
             case '=': {
-                appendCharacterAndFetchNext(currentCharacter, token);
+                fetchNextCharacter();
                 token.kind = TokenKind::RelationalLesserThanOrEquals;
                 return;
             }
             case '<': {
-                appendCharacterAndFetchNext(currentCharacter, token);
+                fetchNextCharacter();
 
                 if (matchCharacter('=')) {
-                    appendCharacterAndFetchNext(currentCharacter, token);
+                    fetchNextCharacter();
                     token.kind = TokenKind::AssignmentLogicalLeftShift;
                     return;
                 }
@@ -267,19 +637,18 @@ public:
             return;
         }
         case '>': {
-            appendCharacterAndFetchNext(currentCharacter, token);
+            fetchNextCharacter();
 
             switch (currentCharacter) {
             case '=': {
-                appendCharacterAndFetchNext(currentCharacter, token);
+                fetchNextCharacter();
                 token.kind = TokenKind::RelationalGreaterThanOrEquals;
                 return;
             }
             case '>': {
-                appendCharacterAndFetchNext(currentCharacter, token);
+                fetchNextCharacter();
 
                 if (matchCharacter('=')) {
-                    token.appendCharacter(currentCharacter);
                     fetchNextCharacter();
                     token.kind = TokenKind::AssignmentLogicalRightShift;
                     return;
@@ -296,41 +665,36 @@ public:
         }
         case '\'':
         case '"': {
-            readString(token);
+            readString(token, currentPosition, StringPrefix());
             return;
         }
         default:
-            if (iswdigit(currentCharacter)) {
+            if (isDigitCharacter(currentCharacter)) {
                 readNumber(token);
                 return;
             }
-            else if (
-                iswalpha(currentCharacter) 
-                || matchCharacter('_')
-            ) {
+            else if (isNameStartCharacter(currentCharacter)) {
                 readName(token);
                 return;
             }
             else {
-                Location thisLocation(
-                    getFileName(), 
-                    currentLineNumber, 
-                    currentColumnNumber
-                );
+                Location thisLocation = getCurrentLocation();
+                auto character = currentCharacter;
+
+                // skipped, so that reading can go on after the error
+                fetchNextCharacter();
 
-                ErrorReporter::reportError(
+                diagnostics->reportFatalError(
                     formatAsString(
                         "unrecognized character: ",
-                        convertCodepointToHex(currentCharacter)
+                        convertCodepointToHex(character)
                     ),
                     thisLocation
                 );
-                quit();
             }
         }
     }
 
-private:
     inline bool matchCharacter(uint32_t val) const {
         return currentCharacter == val;
     }
@@ -339,33 +703,51 @@ private:
         return matchCharacter(0);
     }
 
-    void fetchNextCharacter() {
-        if (not characterBuffer.empty()) {
-            currentCharacter = characterBuffer.back();
-            characterBuffer.pop_back();
-            currentColumnNumber++;
-        }
-        else {
-            currentCharacter = reader.getCharacter();
-            currentColumnNumber++;
-        }
+    inline void fetchNextCharacter() {
+        currentPosition = reader.getCursor();
+        currentCharacter = reader.getCharacter();
+        currentColumnNumber++;
     }
 
-    inline void putbackCharacter(uint32_t val) {
-        characterBuffer.push_back(val);
-        currentColumnNumber--;
+    inline void skipWhitespace(Token& token) {
+        while (isSpaceCharacter(currentCharacter)) {
+            if (matchCharacter('\n')) {
+                token.virtualOffset = 0;
+                startNewLine();
+            }
+            else if (matchCharacter('\t')) {
+                token.virtualOffset += 4;
+            }
+            else if (matchCharacter(' ')) {
+                token.virtualOffset += 1 + skipBytes(
+                    skipSpaces(reader.getCursor(), reader.getEnd())
+                );
+            }
+            else {
+                token.virtualOffset += 1;
+            }
+            fetchNextCharacter();
+        }
     }
 
-    inline void appendCharacterAndFetchNext(uint32_t value, Token& token) {
-        token.appendCharacter(value);
+    // consumes the current character, keeping it in the token's decoded 
+    // text if the token has one.
+    inline void keepCharacterAndFetchNext(Token& token) {
+        if (token.isDecoded()) {
+            token.appendText(
+                std::string_view(
+                    currentPosition, 
+                    reader.getCursor() - currentPosition
+                )
+            );
+        }
         fetchNextCharacter();
     }
 
     inline void skipSpace() {
-        while (iswspace(currentCharacter)) {
+        while (isSpaceCharacter(currentCharacter)) {
             if (matchCharacter('\n')) {
-                currentLineNumber++;
-                currentColumnNumber = 0;
+                startNewLine();
             }
             fetchNextCharacter();
         }
@@ -373,86 +755,459 @@ private:
 
     inline const Location getCurrentLocation() const {
         Location location(
-            getFileName(), 
-            currentLineNumber, 
-            currentColumnNumber
+            fileId, 
+            currentPosition - reader.getData().data()
         );
         return location;
     }
 
-    inline void skipInlineComment() {
-        while (not matchCharacter('\n')) {
-            fetchNextCharacter();
+    // called while the current character is a '\n'
+    inline void startNewLine() {
+        currentLineNumber++;
+        currentColumnNumber = 0;
+
+        addLineStart(reader.getOffset());
+    }
+
+    // lines read again after a seek, or stepped over before, are known 
+    // already
+    inline void addLineStart(size_t offset) {
+        if (offset > sourceFile->lineStarts.back()) {
+            sourceFile->lineStarts.push_back(offset);
         }
     }
 
-    inline void readName(Token& token) {
-        while (iswalnum(currentCharacter) || matchCharacter('_')) {
-            appendCharacterAndFetchNext(currentCharacter, token);
+    // where skipBlock() has got to
+    struct BlockScan {
+        const char* position;
+        size_t lineNumber;
+        const char* lineStart;
+        const char* previousLineStart {nullptr};
+    };
+
+    // steps over the '\n' at the scan's position
+    inline void passLineBreak(BlockScan& scan) {
+        scan.position++;
+        scan.lineNumber++;
+        scan.previousLineStart = scan.lineStart;
+        scan.lineStart = scan.position;
+        addLineStart(scan.position - reader.getData().data());
+    }
+
+    // The first byte after the spaces at 'position' other than '\n', adding 
+    // the width the lexer gives them to 'width'; nullptr at a non-ascii 
+    // byte, which may start a wider space.
+    static const char* skipIndentation(
+        const char* position, 
+        const char* end, 
+        uint64_t& width
+    ) {
+        for (; position != end; ++position) {
+            auto byte = static_cast<unsigned char>(*position);
+
+            if (byte >= 0x80) {
+                return nullptr;
+            }
+
+            if ((byte == '\n') || not isSpaceCharacter(byte)) {
+                break;
+            }
+
+            width += (byte == '\t') ? 4 : 1;
         }
-        token.kind = getKindOfWord(token.value);
+        return position;
     }
 
-    // @note: this function is very minimalistic at the moment.
-    // ... There are various number formats that it can't understand.
-    inline void readNumber(Token& token) {
-        while (iswdigit(currentCharacter)) {
-            appendCharacterAndFetchNext(currentCharacter, token);
+    // Steps over a line, and the lines its brackets and strings run on to, 
+    // up to the '\n' that ends it, or to the end of the source. 'contentEnd' 
+    // follows the end of the last token but ';'s.
+    inline void skipLogicalLine(
+        BlockScan& scan, 
+        const char* end, 
+        size_t& contentEnd
+    ) {
+        const char* const data = reader.getData().data();
+        int depth = 0;
+
+        while (scan.position != end) {
+            // nothing up to the next quote, bracket, comment or line break 
+            // changes the depth; the last byte of it but spaces and ';'s 
+            // ends a token
+            const char* next = findBlockSpecial(scan.position, end);
+
+            for (auto last = next; last != scan.position; --last) {
+                auto byte = static_cast<unsigned char>(last[-1]);
+
+                if ((byte != ';') && not isSpaceCharacter(byte)) {
+                    contentEnd = last - data;
+                    break;
+                }
+            }
+
+            scan.position = next;
+
+            if (scan.position == end) {
+                return;
+            }
+
+            switch (*scan.position) {
+            case '\0':
+                return;
+            case '\n':
+                if (depth == 0) {
+                    return;
+                }
+                passLineBreak(scan);
+                break;
+            case '#':
+                scan.position = findNewline(scan.position, end);
+                break;
+            case '\'':
+            case '"':
+                skipStringBytes(scan, end);
+                contentEnd = scan.position - data;
+                break;
+            case '(':
+            case '[':
+            case '{':
+                depth++;
+                contentEnd = ++scan.position - data;
+                break;
+            default:
+                depth = std::max(depth - 1, 0);
+                contentEnd = ++scan.position - data;
+                break;
+            }
         }
+    }
 
-        if (matchCharacter('j')) {
-            appendCharacterAndFetchNext(currentCharacter, token);
-            token.kind = TokenKind::ConstantImaginary;
-            return;
+    // steps over a string literal from its opening quote, as readString() 
+    // would; an unterminated one runs to the end of the source
+    inline void skipStringBytes(BlockScan& scan, const char* end) {
+        const char quote = *scan.position++;
+        bool isMultiline = false;
+
+        if ((scan.position != end) && (*scan.position == quote)) {
+            scan.position++;
+
+            if ((scan.position == end) || (*scan.position != quote)) {
+                return;
+            }
+
+            scan.position++;
+            isMultiline = true;
+        }
+
+        while (1) {
+            scan.position = findStringSpecial(scan.position, end, quote);
+
+            if (scan.position == end) {
+                return;
+            }
+
+            switch (*scan.position) {
+            case '\n':
+                passLineBreak(scan);
+                break;
+            case '\\':
+                scan.position++;
+
+                if (scan.position == end) {
+                    return;
+                }
+
+                if (*scan.position == '\n') {
+                    passLineBreak(scan);
+                }
+                else {
+                    scan.position++;
+                }
+                break;
+            default:
+                scan.position++;
+
+                if (not isMultiline) {
+                    return;
+                }
+
+                if (
+                    ((end - scan.position) >= 2) 
+                    && (scan.position[0] == quote) 
+                    && (scan.position[1] == quote)
+                ) {
+                    scan.position += 2;
+                    return;
+                }
+                break;
+            }
+        }
+    }
+
+    // whether the text at 'position' starts with a keyword that goes on 
+    // with the compound statement before it
+    static bool startsClause(const char* position, const char* end) {
+        for (std::string_view word : { "elif", "else", "except", "finally" }) {
+            size_t length = word.size();
+
+            if (
+                (size_t(end - position) >= length)
+                && (std::string_view(position, length) == word)
+                && (
+                    (size_t(end - position) == length)
+                    || not isNameCharacter(
+                        static_cast<unsigned char>(position[length])
+                    )
+                )
+            ) {
+                return true;
+            }
         }
+        return false;
+    }
+
+    // the number of utf8 characters from 'position' to 'end'
+    static size_t countCharacters(const char* position, const char* end) {
+        size_t count = 0;
+
+        for (; position != end; ++position) {
+            if ((static_cast<unsigned char>(*position) & 0xc0) != 0x80) {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    // moves the reader up to the given position, which must not be in the 
+    // middle of a line break, and returns the number of bytes skipped.
+    inline size_t skipBytes(const char* position) {
+        size_t count = position - reader.getCursor();
+        currentColumnNumber += count;
+        reader.skipTo(position);
+        return count;
+    }
+
+    inline void skipInlineComment() {
+        fetchNextCharacter(); // skip '#'
 
-        if (not matchCharacter('.')) {
-            token.kind = TokenKind::ConstantInteger;
+        if (matchCharacter('\n') || fileEnded()) {
             return;
         }
 
+        skipBytes(
+            findNewline(reader.getCursor(), reader.getEnd())
+        );
         fetchNextCharacter();
+    }
 
-        if (not iswdigit(currentCharacter)) {
-            putbackCharacter(currentCharacter);
+    // ascii runs are skipped straight over the source bytes; only non-ascii 
+    // characters go through utf8 decoding.
+    inline void readName(Token& token) {
+        const char* start = currentPosition;
 
-            putbackCharacter('.');
+        while (isNameCharacter(currentCharacter)) {
+            skipBytes(skipNameBytes(reader.getCursor(), reader.getEnd()));
             fetchNextCharacter();
-            
-            token.kind = TokenKind::ConstantInteger;
+        }
+
+        std::string_view word(start, currentPosition - start);
+        StringPrefix prefix;
+
+        if (
+            (matchCharacter('"') || matchCharacter('\''))
+            && readStringPrefix(word, prefix)
+        ) {
+            readString(token, start, prefix);
             return;
         }
 
-        token.appendCharacter('.');
-        appendCharacterAndFetchNext(currentCharacter, token);
+        token.kind = getKindOfWord(word);
+    }
+
+    // Reads a numeric literal: a decimal, hex (0x), octal (0o) or binary 
+    // (0b) integer, a float with a fraction and/or an exponent, or either 
+    // of the decimal forms with a 'j' to make it imaginary. Digits may be 
+    // separated by single underscores. The token's text is the literal as 
+    // written; its value is worked out by the parser.
+    inline void readNumber(Token& token) {
+        token.kind = TokenKind::ConstantInteger;
+
+        if (matchCharacter('0')) {
+            int base = 0;
+
+            switch (reader.peekByte() | 0x20) {
+            case 'x': base = 16; break;
+            case 'o': base = 8;  break;
+            case 'b': base = 2;  break;
+            }
+
+            if (base != 0) {
+                auto location = getCurrentLocation();
+                fetchNextCharacter();
+                fetchNextCharacter();
+
+                if (
+                    (readDigits(base, true) == 0) 
+                    || (getHexDigitValue(currentCharacter) >= 0)
+                ) {
+                    diagnostics->reportError(
+                        formatAsString("invalid base ", base, " literal"), 
+                        location
+                    );
+
+                    // the rest of the literal, so it is not read as a name
+                    while (isNameCharacter(currentCharacter)) {
+                        fetchNextCharacter();
+                    }
+                }
+                return;
+            }
+        }
+
+        auto location = getCurrentLocation();
+        const char* start = currentPosition;
+        bool isFloat = false;
+
+        readDigits(10, false);
+
+        // "0", "00" and so on are fine; "012" is not
+        bool hasLeadingZero = (*start == '0') 
+            && (std::string_view(start, currentPosition - start)
+                .find_first_not_of("0_") != std::string_view::npos);
+
+        if (matchCharacter('.')) {
+            fetchNextCharacter();
+            isFloat = true;
+            readDigits(10, false);
+        }
+
+        if ((currentCharacter | 0x20) == 'e') {
+            auto next = reader.getCursor();
+            auto end = reader.getEnd();
 
-        while (iswdigit(currentCharacter)) {
-            appendCharacterAndFetchNext(currentCharacter, token);
+            if ((next != end) && ((*next == '+') || (*next == '-'))) {
+                next++;
+            }
+
+            if ((next != end) && isDigitCharacter(static_cast<unsigned char>(*next))) {
+                skipBytes(next);
+                fetchNextCharacter();
+                readDigits(10, false);
+                isFloat = true;
+            }
         }
 
-        if (matchCharacter('j')) {
-            appendCharacterAndFetchNext(currentCharacter, token);
+        if ((currentCharacter | 0x20) == 'j') {
+            fetchNextCharacter();
             token.kind = TokenKind::ConstantImaginary;
             return;
         }
 
-        token.kind = TokenKind::ConstantFloat;
+        if (isFloat) {
+            token.kind = TokenKind::ConstantFloat;
+        }
+        else if (hasLeadingZero) {
+            diagnostics->reportError(
+                "leading zeros are not allowed in decimal integer literals; "
+                "use 0o for octal", 
+                location
+            );
+        }
     }
 
-    inline void readString(Token& token) {
+    // Reads digits of the given base (2, 8, 10 or 16) with single 
+    // underscores between them, or before the first if 'leadingUnderscore'.
+    // Returns the number of digits read.
+    inline size_t readDigits(int base, bool leadingUnderscore) {
+        size_t count = 0;
+
+        while (1) {
+            if (matchCharacter('_') && ((count > 0) || leadingUnderscore)) {
+                int next = getHexDigitValue(reader.peekByte());
+
+                if ((next < 0) || (next >= base)) {
+                    diagnostics->reportError(
+                        "an underscore in a number must be followed by a digit",
+                        getCurrentLocation()
+                    );
+                    fetchNextCharacter();
+                    return count;
+                }
+
+                fetchNextCharacter();
+            }
+
+            int digit = getHexDigitValue(currentCharacter);
+
+            if ((digit < 0) || (digit >= base)) {
+                return count;
+            }
+
+            fetchNextCharacter();
+            count++;
+        }
+    }
+
+    // the prefix letters of a string literal; 'f' is not supported
+    struct StringPrefix {
+        bool isRaw {false};
+        bool isBytes {false};
+    };
+
+    static bool readStringPrefix(std::string_view word, StringPrefix& prefix) {
+        if (word.size() > 2) {
+            return false;
+        }
+
+        bool sawUnicode = false;
+
+        for (char c : word) {
+            switch (c) {
+            case 'r': case 'R':
+                if (prefix.isRaw) {
+                    return false;
+                }
+                prefix.isRaw = true;
+                break;
+            case 'b': case 'B':
+                if (prefix.isBytes) {
+                    return false;
+                }
+                prefix.isBytes = true;
+                break;
+            case 'u': case 'U':
+                sawUnicode = true;
+                break;
+            default:
+                return false;
+            }
+        }
+
+        // 'u' only ever appears on its own
+        return not (sawUnicode && (word.size() > 1));
+    }
+
+    // Reads a string literal whose prefix (if any) starts at 'start'; the 
+    // current character is the opening quote. The token's text is the 
+    // literal as written, prefix and quotes included. Strings with escape 
+    // sequences switch to decoded storage at the first backslash.
+    inline void readString(
+        Token& token, 
+        const char* start, 
+        StringPrefix prefix
+    ) {
         token.kind = TokenKind::ConstantString;
 
         const auto openingCharacter = currentCharacter;
         const auto startingLocation = getCurrentLocation();
 
-        appendCharacterAndFetchNext(currentCharacter, token);
+        fetchNextCharacter();
 
         bool isMultiline = false;
 
-        if ((openingCharacter == '"') && matchCharacter('"')) {
-            appendCharacterAndFetchNext(currentCharacter, token);
-            if (matchCharacter('"')) {
-                appendCharacterAndFetchNext(currentCharacter, token);
+        if (matchCharacter(openingCharacter)) {
+            fetchNextCharacter();
+            if (matchCharacter(openingCharacter)) {
+                fetchNextCharacter();
                 isMultiline = true;
                 token.kind = TokenKind::ConstantMultilineString;
             }
@@ -464,86 +1219,279 @@ private:
         while (not fileEnded()) {
             switch (currentCharacter) {
             case '\n': {
-                token.appendCharacter(currentCharacter);
-                currentLineNumber++;
-                currentColumnNumber = 0;
-                fetchNextCharacter();
+                startNewLine();
+                keepCharacterAndFetchNext(token);
                 break;
             }
             case '\\': {
-                fetchNextCharacter();
+                if (prefix.isRaw) {
+                    // kept, along with whatever it escapes
+                    keepCharacterAndFetchNext(token);
 
-                switch (currentCharacter) {
-                case 't':  token.appendCharacter('\t'); break;
-                case '"':  token.appendCharacter('"');  break;
-                case '\'': token.appendCharacter('\''); break;
-                case 'n':  token.appendCharacter('\n'); break;
-                default:
-                    auto location = getCurrentLocation();
-                    ErrorReporter::reportWarning(
-                        formatAsString(
-                            "unrecognized escape sequence: \\",
-                            convertCodepointToHex(currentCharacter)
-                        ),
-                        location
+                    if (matchCharacter('\n')) {
+                        startNewLine();
+                    }
+
+                    if (not fileEnded()) {
+                        keepCharacterAndFetchNext(token);
+                    }
+                    break;
+                }
+
+                if (not token.isDecoded()) {
+                    token.beginDecoding(
+                        std::string_view(start, currentPosition - start)
                     );
-                    token.appendCharacter('\\');
-                    continue;
                 }
 
                 fetchNextCharacter();
+                readEscapeSequence(token, prefix.isBytes);
                 break;
             }
             default:
-                token.appendCharacter(currentCharacter);
-                if ((openingCharacter == '"') && matchCharacter('"')) {
-                    fetchNextCharacter();
+                if (matchCharacter(openingCharacter)) {
+                    keepCharacterAndFetchNext(token);
 
                     if (not isMultiline) {
                         return;
                     }
 
-                    if (not matchCharacter('"')) {
+                    if (not matchCharacter(openingCharacter)) {
                         continue;
                     }
 
-                    appendCharacterAndFetchNext(currentCharacter, token);
+                    keepCharacterAndFetchNext(token);
 
-                    if (matchCharacter('"')) {
-                        appendCharacterAndFetchNext(
-                            currentCharacter, 
-                            token
-                        );
+                    if (matchCharacter(openingCharacter)) {
+                        keepCharacterAndFetchNext(token);
                         return;
                     }
 
                     continue;
                 } 
-                else if (
-                    (openingCharacter == '\'') 
-                    && matchCharacter('\'')
-                ) {
-                    fetchNextCharacter();
-                    return;
-                }
                 else {
+                    // everything up to the next quote, escape or newline 
+                    // is taken as it is
+                    const char* runStart = currentPosition;
+
+                    skipBytes(
+                        findStringSpecial(
+                            reader.getCursor(), 
+                            reader.getEnd(), 
+                            openingCharacter
+                        )
+                    );
                     fetchNextCharacter();
+
+                    if (token.isDecoded()) {
+                        token.appendText(
+                            std::string_view(
+                                runStart, 
+                                currentPosition - runStart
+                            )
+                        );
+                    }
                 }
             }
         }
 
-        ErrorReporter::reportFatalError(
+        diagnostics->reportFatalError(
             "unterminated string constant",
             startingLocation
         );
     }
 
+    // Decodes the escape sequence whose backslash was just read, into the 
+    // token's decoded text. Unknown escapes keep their backslash, as they 
+    // do in python.
+    inline void readEscapeSequence(Token& token, bool isBytes) {
+        uint32_t value = 0;
+
+        switch (currentCharacter) {
+        case '\n':
+            // a backslash at the end of a line joins it with the next one
+            startNewLine();
+            fetchNextCharacter();
+            return;
+        case '\\': value = '\\'; break;
+        case '\'': value = '\''; break;
+        case '"':  value = '"';  break;
+        case 'a':  value = '\a'; break;
+        case 'b':  value = '\b'; break;
+        case 'f':  value = '\f'; break;
+        case 'n':  value = '\n'; break;
+        case 'r':  value = '\r'; break;
+        case 't':  value = '\t'; break;
+        case 'v':  value = '\v'; break;
+        case '0': case '1': case '2': case '3':
+        case '4': case '5': case '6': case '7': {
+            auto location = getCurrentLocation();
+
+            for (
+                int i = 0; 
+                (i < 3) && (currentCharacter >= '0') && (currentCharacter <= '7'); 
+                ++i
+            ) {
+                value = (value * 8) + (currentCharacter - '0');
+                fetchNextCharacter();
+            }
+
+            appendEscapedValue(token, value, isBytes, location);
+            return;
+        }
+        case 'x':
+            readHexEscape(token, 2, isBytes);
+            return;
+        case 'N':
+            if (not isBytes) {
+                readNamedEscape(token);
+                return;
+            }
+            [[fallthrough]];
+        case 'u':
+        case 'U':
+            if (not isBytes) {
+                readHexEscape(token, matchCharacter('u') ? 4 : 8, isBytes);
+                return;
+            }
+            [[fallthrough]];
+        default: {
+            auto location = getCurrentLocation();
+            diagnostics->reportWarning(
+                formatAsString(
+                    "unrecognized escape sequence: \\",
+                    convertCodepointToHex(currentCharacter)
+                ),
+                location
+            );
+
+            // the character itself is read as usual
+            token.appendCharacter('\\');
+            return;
+        }
+        }
+
+        token.appendCharacter(value);
+        fetchNextCharacter();
+    }
+
+    // reads the 'N' of a "\N{name}" escape and the braced name after it; 
+    // the name is not looked up, only checked for its shape
+    inline void readNamedEscape(Token& token) {
+        auto location = getCurrentLocation();
+        bool hasName = false;
+
+        fetchNextCharacter();
+
+        if (matchCharacter('{')) {
+            fetchNextCharacter();
+
+            // names are made of ascii letters, digits, spaces and '-'s
+            while (
+                ((currentCharacter < 0x80) && isNameCharacter(currentCharacter))
+                || matchCharacter(' ') 
+                || matchCharacter('-')
+            ) {
+                hasName = true;
+                fetchNextCharacter();
+            }
+        }
+
+        if (not hasName or not matchCharacter('}')) {
+            diagnostics->reportError("malformed \\N character escape", location);
+            return;
+        }
+
+        fetchNextCharacter();
+        token.hasNamedEscape = true;
+    }
+
+    // reads the 'x', 'u' or 'U' of an escape and the hex digits after it
+    inline void readHexEscape(Token& token, int numberOfDigits, bool isBytes) {
+        auto location = getCurrentLocation();
+        uint32_t value = 0;
+
+        fetchNextCharacter();
+
+        for (int i = 0; i < numberOfDigits; ++i) {
+            int digit = getHexDigitValue(currentCharacter);
+
+            if (digit < 0) {
+                diagnostics->reportError(
+                    formatAsString(
+                        "truncated escape sequence; expected ", 
+                        numberOfDigits, 
+                        " hex digits"
+                    ),
+                    location
+                );
+                return;
+            }
+
+            value = (value * 16) + digit;
+            fetchNextCharacter();
+        }
+
+        appendEscapedValue(token, value, isBytes, location);
+    }
+
+    // bytes literals take the value as a single byte; strings take it as a 
+    // code point, stored as utf8
+    inline void appendEscapedValue(
+        Token& token, 
+        uint32_t value, 
+        bool isBytes, 
+        const Location& location
+    ) {
+        if (value > (isBytes ? 0xffu : 0x10ffffu)) {
+            diagnostics->reportError(
+                formatAsString(
+                    "escape sequence out of range: ", 
+                    convertCodepointToHex(value)
+                ),
+                location
+            );
+            return;
+        }
+
+        if (isBytes) {
+            const char byte = static_cast<char>(value);
+            token.appendText(std::string_view(&byte, 1));
+        }
+        else {
+            token.appendCharacter(value);
+        }
+    }
+
+    static int getHexDigitValue(uint32_t c) {
+        if ((c >= '0') && (c <= '9')) {
+            return c - '0';
+        }
+
+        c |= 0x20;
+
+        if ((c >= 'a') && (c <= 'f')) {
+            return c - 'a' + 10;
+        }
+
+        return -1;
+    }
+
     uint32_t currentCharacter;
-    std::vector<uint32_t> characterBuffer;
+    const char* currentPosition {nullptr}; // where currentCharacter starts
 
     size_t currentLineNumber;
     size_t currentColumnNumber;
 
+    uint32_t fileId {0};
+    SourceFile* sourceFile {nullptr};
+
+    // read after a "not" or an "is" that turned out not to be "not in" or 
+    // "is not", to be handed out next
+    Token pendingToken;
+    bool hasPendingToken {false};
+
     Reader reader;
+    Diagnostics* diagnostics;
 };
 
@@ -1,44 +1,113 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <cstdint>
 
 class Reader {
 public:
     Reader() = default;
-    Reader(const Reader&) = default;
-    Reader(Reader&&) = default;
+    Reader(const Reader&) = delete;
+
+    // The cursor and the end point into the source, which may move along 
+    // with it, since a short read() fallback buffer lives inside its 
+    // string. Readers that share this one's source keep pointing at the 
+    // old one, so it must not be moved while they are in use.
+    Reader(Reader&& other) noexcept
+        : fileName(std::move(other.fileName)),
+          owner(other.owner) {
+        if (not other.cursor) {
+            source = std::move(other.source);
+            return;
+        }
+
+        auto data = other.getData().data();
+        auto cursorOffset = other.cursor - data;
+        auto endOffset = other.end - data;
+
+        source = std::move(other.source);
+        cursor = getData().data() + cursorOffset;
+        end = getData().data() + endOffset;
+    }
+
     ~Reader() = default;
 
     [[nodiscard]]
     bool openFile(std::string fileName) {
-        if (not readFileDataIntoBuffer(fileName, this->fileData)) {
+        if (not source.open(fileName)) {
             return false;
         }
 
         this->fileName = std::move(fileName);
-        fileDataIterator = std::begin(fileData);
+        cursor = source.begin();
+        end = source.end();
 
         return true;
     }
 
+    // reads the source of another reader, which must outlive this one
+    void shareSource(const Reader& other) {
+        fileName = other.fileName;
+        owner = other.owner ? other.owner : &other;
+        cursor = other.getData().data();
+        end = cursor + other.getData().size();
+    }
+
     uint32_t getCharacter() {
-        if (fileDataIterator == fileData.end()) {
+        if (cursor == end) {
+            return 0;
+        }
+
+        if (static_cast<unsigned char>(*cursor) < 0x80) {
+            return *cursor++;
+        }
+
+        return GeniusC::GetUtf8Character(cursor, end);
+    }
+
+    // the byte after the current character, without consuming it
+    unsigned char peekByte() const {
+        if (cursor == end) {
             return 0;
         }
+        return *cursor;
+    }
+
+    const char* getCursor() const {
+        return cursor;
+    }
+
+    const char* getEnd() const {
+        return end;
+    }
 
-        return GeniusC::GetUtf8Character(
-            fileDataIterator, 
-            std::end(fileData)
-        );
+    // reads stop at 'position', as if the source ended there
+    void setEnd(const char* position) {
+        end = position;
+    }
+
+    void skipTo(const char* position) {
+        cursor = position;
     }
 
     const std::string& getFileName() const {
         return fileName;
     }
 
+    // the whole source; views into it stay valid while the reader lives
+    std::string_view getData() const {
+        return owner ? owner->source.view() : source.view();
+    }
+
+    // byte offset of the next character to be read
+    size_t getOffset() const {
+        return cursor - getData().data();
+    }
+
 private:
     std::string fileName;
-    std::string fileData;
-    std::string::iterator fileDataIterator;
+    SourceBuffer source;
+    const Reader* owner {nullptr}; // whose source is read, if not this one's
+    const char* cursor {nullptr};
+    const char* end {nullptr};
 };
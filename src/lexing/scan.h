@@ -0,0 +1,606 @@
+#pragma once
+
+#include <cstring>
+
+#include "charclass.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define PET_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+// Kernels that find the next interesting byte in a run of source text, 
+// 16 (SSE2) or 32 (AVX2) bytes at a time. The best variant the cpu supports 
+// is picked once at startup; other targets use the scalar versions. Every 
+// kernel returns 'end' when nothing was found.
+
+// first byte that is not a ' '
+inline const char* skipSpacesScalar(const char* position, const char* end) {
+    while ((position != end) && (*position == ' ')) {
+        position++;
+    }
+    return position;
+}
+
+// first byte that is not [A-Za-z0-9_]; bytes >= 0x80 also stop the scan
+inline const char* skipNameBytesScalar(const char* position, const char* end) {
+    while (
+        (position != end) 
+        && hasCharacterClass(*position, CharacterClassName)
+    ) {
+        position++;
+    }
+    return position;
+}
+
+inline const char* findNewlineScalar(const char* position, const char* end) {
+    auto found = static_cast<const char*>(
+        memchr(position, '\n', end - position)
+    );
+    return found ? found : end;
+}
+
+// first quote (of the given kind), backslash or newline
+inline const char* findStringSpecialScalar(
+    const char* position, 
+    const char* end, 
+    char quote
+) {
+    while (position != end) {
+        char c = *position;
+        if ((c == quote) || (c == '\\') || (c == '\n')) {
+            break;
+        }
+        position++;
+    }
+    return position;
+}
+
+// whether a byte is a quote, a bracket, a '#', a newline or a NUL: where 
+// something may change for a scan that steps over code without reading 
+// its tokens
+inline bool isBlockSpecial(char c) {
+    switch (c) {
+    case '"': case '\'': case '#': case '\n': case '\0':
+    case '(': case ')': case '[': case ']': case '{': case '}':
+        return true;
+    default:
+        return false;
+    }
+}
+
+inline const char* findBlockSpecialScalar(
+    const char* position, 
+    const char* end
+) {
+    while ((position != end) && not isBlockSpecial(*position)) {
+        position++;
+    }
+    return position;
+}
+
+// first byte that cannot be written as it is inside a double-quoted 
+// literal: a quote, backslash, control character or DEL, and also any byte 
+// >= 0x80 if 'escapeHighBytes' is set
+inline bool needsEscape(unsigned char c, bool escapeHighBytes) {
+    return (c < 0x20) || (c == '"') || (c == '\\') || (c == 0x7f) 
+        || (escapeHighBytes && (c >= 0x80));
+}
+
+inline const char* findEscapeByteScalar(
+    const char* position, 
+    const char* end, 
+    bool escapeHighBytes
+) {
+    while (
+        (position != end) 
+        && (not needsEscape(*position, escapeHighBytes))
+    ) {
+        position++;
+    }
+    return position;
+}
+
+#ifdef PET_SCAN_X86
+
+inline int countTrailingZeros(unsigned mask) {
+    return __builtin_ctz(mask);
+}
+
+// lanes holding [A-Za-z0-9_]
+inline __m128i nameByteMask128(__m128i bytes) {
+    const __m128i lower = _mm_or_si128(bytes, _mm_set1_epi8(0x20));
+    const __m128i letters = _mm_cmplt_epi8(
+        _mm_add_epi8(lower, _mm_set1_epi8(static_cast<char>(128 - 'a'))),
+        _mm_set1_epi8(static_cast<char>(-128 + 26))
+    );
+    const __m128i digits = _mm_cmplt_epi8(
+        _mm_add_epi8(bytes, _mm_set1_epi8(static_cast<char>(128 - '0'))),
+        _mm_set1_epi8(static_cast<char>(-128 + 10))
+    );
+    const __m128i underscores = _mm_cmpeq_epi8(bytes, _mm_set1_epi8('_'));
+    return _mm_or_si128(_mm_or_si128(letters, digits), underscores);
+}
+
+inline const char* skipSpacesSse2(const char* position, const char* end) {
+    const __m128i spaces = _mm_set1_epi8(' ');
+
+    while (end - position >= 16) {
+        auto bytes = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(position)
+        );
+        unsigned mask = 
+            ~_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, spaces)) & 0xffff;
+
+        if (mask != 0) {
+            return position + countTrailingZeros(mask);
+        }
+        position += 16;
+    }
+
+    return skipSpacesScalar(position, end);
+}
+
+inline const char* skipNameBytesSse2(const char* position, const char* end) {
+    while (end - position >= 16) {
+        auto bytes = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(position)
+        );
+        unsigned mask = 
+            ~_mm_movemask_epi8(nameByteMask128(bytes)) & 0xffff;
+
+        if (mask != 0) {
+            return position + countTrailingZeros(mask);
+        }
+        position += 16;
+    }
+
+    return skipNameBytesScalar(position, end);
+}
+
+inline const char* findNewlineSse2(const char* position, const char* end) {
+    const __m128i newlines = _mm_set1_epi8('\n');
+
+    while (end - position >= 16) {
+        auto bytes = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(position)
+        );
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newlines));
+
+        if (mask != 0) {
+            return position + countTrailingZeros(mask);
+        }
+        position += 16;
+    }
+
+    return findNewlineScalar(position, end);
+}
+
+inline const char* findStringSpecialSse2(
+    const char* position, 
+    const char* end, 
+    char quote
+) {
+    const __m128i quotes = _mm_set1_epi8(quote);
+    const __m128i backslashes = _mm_set1_epi8('\\');
+    const __m128i newlines = _mm_set1_epi8('\n');
+
+    while (end - position >= 16) {
+        auto bytes = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(position)
+        );
+        auto matches = _mm_or_si128(
+            _mm_or_si128(
+                _mm_cmpeq_epi8(bytes, quotes), 
+                _mm_cmpeq_epi8(bytes, backslashes)
+            ),
+            _mm_cmpeq_epi8(bytes, newlines)
+        );
+        unsigned mask = _mm_movemask_epi8(matches);
+
+        if (mask != 0) {
+            return position + countTrailingZeros(mask);
+        }
+        position += 16;
+    }
+
+    return findStringSpecialScalar(position, end, quote);
+}
+
+inline const char* findBlockSpecialSse2(const char* position, const char* end) {
+    // '(' and ')', and '"' and '#', differ only in the lowest bit; '[' 
+    // and '{', and ']' and '}', only in 0x20
+    const __m128i ones = _mm_set1_epi8(1);
+    const __m128i cases = _mm_set1_epi8(0x20);
+    const __m128i parentheses = _mm_set1_epi8(')');
+    const __m128i hashes = _mm_set1_epi8('#');
+    const __m128i openBraces = _mm_set1_epi8('{');
+    const __m128i closeBraces = _mm_set1_epi8('}');
+    const __m128i quotes = _mm_set1_epi8('\'');
+    const __m128i newlines = _mm_set1_epi8('\n');
+    const __m128i zeros = _mm_setzero_si128();
+
+    while (end - position >= 16) {
+        auto bytes = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(position)
+        );
+        auto lowBit = _mm_or_si128(bytes, ones);
+        auto lowerCase = _mm_or_si128(bytes, cases);
+        auto matches = _mm_or_si128(
+            _mm_or_si128(
+                _mm_or_si128(
+                    _mm_cmpeq_epi8(lowBit, parentheses), 
+                    _mm_cmpeq_epi8(lowBit, hashes)
+                ),
+                _mm_or_si128(
+                    _mm_cmpeq_epi8(lowerCase, openBraces), 
+                    _mm_cmpeq_epi8(lowerCase, closeBraces)
+                )
+            ),
+            _mm_or_si128(
+                _mm_cmpeq_epi8(bytes, quotes),
+                _mm_or_si128(
+                    _mm_cmpeq_epi8(bytes, newlines), 
+                    _mm_cmpeq_epi8(bytes, zeros)
+                )
+            )
+        );
+        unsigned mask = _mm_movemask_epi8(matches);
+
+        if (mask != 0) {
+            return position + countTrailingZeros(mask);
+        }
+        position += 16;
+    }
+
+    return findBlockSpecialScalar(position, end);
+}
+
+inline const char* findEscapeByteSse2(
+    const char* position, 
+    const char* end, 
+    bool escapeHighBytes
+) {
+    const __m128i controls = _mm_set1_epi8(0x1f);
+    const __m128i quotes = _mm_set1_epi8('"');
+    const __m128i backslashes = _mm_set1_epi8('\\');
+    const __m128i deletes = _mm_set1_epi8(0x7f);
+    const unsigned highBytes = escapeHighBytes ? 0xffff : 0;
+
+    while (end - position >= 16) {
+        auto bytes = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(position)
+        );
+        auto matches = _mm_or_si128(
+            _mm_or_si128(
+                _mm_cmpeq_epi8(_mm_min_epu8(bytes, controls), bytes),
+                _mm_cmpeq_epi8(bytes, quotes)
+            ),
+            _mm_or_si128(
+                _mm_cmpeq_epi8(bytes, backslashes),
+                _mm_cmpeq_epi8(bytes, deletes)
+            )
+        );
+        unsigned mask = _mm_movemask_epi8(matches) 
+            | (_mm_movemask_epi8(bytes) & highBytes);
+
+        if (mask != 0) {
+            return position + countTrailingZeros(mask);
+        }
+        position += 16;
+    }
+
+    return findEscapeByteScalar(position, end, escapeHighBytes);
+}
+
+__attribute__((target("avx2")))
+inline __m256i nameByteMask256(__m256i bytes) {
+    const __m256i lower = _mm256_or_si256(bytes, _mm256_set1_epi8(0x20));
+    const __m256i letters = _mm256_cmpgt_epi8(
+        _mm256_set1_epi8(static_cast<char>(-128 + 26)),
+        _mm256_add_epi8(lower, _mm256_set1_epi8(static_cast<char>(128 - 'a')))
+    );
+    const __m256i digits = _mm256_cmpgt_epi8(
+        _mm256_set1_epi8(static_cast<char>(-128 + 10)),
+        _mm256_add_epi8(bytes, _mm256_set1_epi8(static_cast<char>(128 - '0')))
+    );
+    const __m256i underscores = 
+        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('_'));
+    return _mm256_or_si256(_mm256_or_si256(letters, digits), underscores);
+}
+
+__attribute__((target("avx2")))
+inline const char* skipSpacesAvx2(const char* position, const char* end) {
+    const __m256i spaces = _mm256_set1_epi8(' ');
+
+    while (end - position >= 32) {
+        auto bytes = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(position)
+        );
+        unsigned mask = 
+            ~_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, spaces));
+
+        if (mask != 0) {
+            return position + countTrailingZeros(mask);
+        }
+        position += 32;
+    }
+
+    return skipSpacesSse2(position, end);
+}
+
+__attribute__((target("avx2")))
+inline const char* skipNameBytesAvx2(const char* position, const char* end) {
+    while (end - position >= 32) {
+        auto bytes = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(position)
+        );
+        unsigned mask = ~_mm256_movemask_epi8(nameByteMask256(bytes));
+
+        if (mask != 0) {
+            return position + countTrailingZeros(mask);
+        }
+        position += 32;
+    }
+
+    return skipNameBytesSse2(position, end);
+}
+
+__attribute__((target("avx2")))
+inline const char* findNewlineAvx2(const char* position, const char* end) {
+    const __m256i newlines = _mm256_set1_epi8('\n');
+
+    while (end - position >= 32) {
+        auto bytes = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(position)
+        );
+        unsigned mask = 
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, newlines));
+
+        if (mask != 0) {
+            return position + countTrailingZeros(mask);
+        }
+        position += 32;
+    }
+
+    return findNewlineSse2(position, end);
+}
+
+__attribute__((target("avx2")))
+inline const char* findStringSpecialAvx2(
+    const char* position, 
+    const char* end, 
+    char quote
+) {
+    const __m256i quotes = _mm256_set1_epi8(quote);
+    const __m256i backslashes = _mm256_set1_epi8('\\');
+    const __m256i newlines = _mm256_set1_epi8('\n');
+
+    while (end - position >= 32) {
+        auto bytes = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(position)
+        );
+        auto matches = _mm256_or_si256(
+            _mm256_or_si256(
+                _mm256_cmpeq_epi8(bytes, quotes), 
+                _mm256_cmpeq_epi8(bytes, backslashes)
+            ),
+            _mm256_cmpeq_epi8(bytes, newlines)
+        );
+        unsigned mask = _mm256_movemask_epi8(matches);
+
+        if (mask != 0) {
+            return position + countTrailingZeros(mask);
+        }
+        position += 32;
+    }
+
+    return findStringSpecialSse2(position, end, quote);
+}
+
+__attribute__((target("avx2")))
+inline const char* findBlockSpecialAvx2(const char* position, const char* end) {
+    // '(' and ')', and '"' and '#', differ only in the lowest bit; '[' 
+    // and '{', and ']' and '}', only in 0x20
+    const __m256i ones = _mm256_set1_epi8(1);
+    const __m256i cases = _mm256_set1_epi8(0x20);
+    const __m256i parentheses = _mm256_set1_epi8(')');
+    const __m256i hashes = _mm256_set1_epi8('#');
+    const __m256i openBraces = _mm256_set1_epi8('{');
+    const __m256i closeBraces = _mm256_set1_epi8('}');
+    const __m256i quotes = _mm256_set1_epi8('\'');
+    const __m256i newlines = _mm256_set1_epi8('\n');
+    const __m256i zeros = _mm256_setzero_si256();
+
+    while (end - position >= 32) {
+        auto bytes = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(position)
+        );
+        auto lowBit = _mm256_or_si256(bytes, ones);
+        auto lowerCase = _mm256_or_si256(bytes, cases);
+        auto matches = _mm256_or_si256(
+            _mm256_or_si256(
+                _mm256_or_si256(
+                    _mm256_cmpeq_epi8(lowBit, parentheses), 
+                    _mm256_cmpeq_epi8(lowBit, hashes)
+                ),
+                _mm256_or_si256(
+                    _mm256_cmpeq_epi8(lowerCase, openBraces), 
+                    _mm256_cmpeq_epi8(lowerCase, closeBraces)
+                )
+            ),
+            _mm256_or_si256(
+                _mm256_cmpeq_epi8(bytes, quotes),
+                _mm256_or_si256(
+                    _mm256_cmpeq_epi8(bytes, newlines), 
+                    _mm256_cmpeq_epi8(bytes, zeros)
+                )
+            )
+        );
+        unsigned mask = _mm256_movemask_epi8(matches);
+
+        if (mask != 0) {
+            return position + countTrailingZeros(mask);
+        }
+        position += 32;
+    }
+
+    return findBlockSpecialSse2(position, end);
+}
+
+__attribute__((target("avx2")))
+inline const char* findEscapeByteAvx2(
+    const char* position, 
+    const char* end, 
+    bool escapeHighBytes
+) {
+    const __m256i controls = _mm256_set1_epi8(0x1f);
+    const __m256i quotes = _mm256_set1_epi8('"');
+    const __m256i backslashes = _mm256_set1_epi8('\\');
+    const __m256i deletes = _mm256_set1_epi8(0x7f);
+    const unsigned highBytes = escapeHighBytes ? ~0u : 0;
+
+    while (end - position >= 32) {
+        auto bytes = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(position)
+        );
+        auto matches = _mm256_or_si256(
+            _mm256_or_si256(
+                _mm256_cmpeq_epi8(_mm256_min_epu8(bytes, controls), bytes),
+                _mm256_cmpeq_epi8(bytes, quotes)
+            ),
+            _mm256_or_si256(
+                _mm256_cmpeq_epi8(bytes, backslashes),
+                _mm256_cmpeq_epi8(bytes, deletes)
+            )
+        );
+        unsigned mask = _mm256_movemask_epi8(matches) 
+            | (_mm256_movemask_epi8(bytes) & highBytes);
+
+        if (mask != 0) {
+            return position + countTrailingZeros(mask);
+        }
+        position += 32;
+    }
+
+    return findEscapeByteSse2(position, end, escapeHighBytes);
+}
+
+#endif // PET_SCAN_X86
+
+struct ScanKernels {
+    const char* (*skipSpaces)(const char*, const char*);
+    const char* (*skipNameBytes)(const char*, const char*);
+    const char* (*findNewline)(const char*, const char*);
+    const char* (*findStringSpecial)(const char*, const char*, char);
+    const char* (*findBlockSpecial)(const char*, const char*);
+    const char* (*findEscapeByte)(const char*, const char*, bool);
+};
+
+inline ScanKernels selectScanKernels() {
+#ifdef PET_SCAN_X86
+    // runs from a static initializer, possibly before the cpu model is set up
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2")) {
+        return {
+            skipSpacesAvx2, 
+            skipNameBytesAvx2, 
+            findNewlineAvx2, 
+            findStringSpecialAvx2,
+            findBlockSpecialAvx2,
+            findEscapeByteAvx2
+        };
+    }
+
+    return {
+        skipSpacesSse2, 
+        skipNameBytesSse2, 
+        findNewlineSse2, 
+        findStringSpecialSse2,
+        findBlockSpecialSse2,
+        findEscapeByteSse2
+    };
+#else
+    return {
+        skipSpacesScalar, 
+        skipNameBytesScalar, 
+        findNewlineScalar, 
+        findStringSpecialScalar,
+        findBlockSpecialScalar,
+        findEscapeByteScalar
+    };
+#endif
+}
+
+inline const ScanKernels scanKernels = selectScanKernels();
+
+// Most runs (indentation, identifiers) are only a few bytes long, so the 
+// first few bytes are checked inline and only longer runs are handed to the 
+// vector kernels.
+constexpr int inlineScanLength = 8;
+
+inline const char* skipSpaces(const char* position, const char* end) {
+    for (int i = 0; i < inlineScanLength; ++i, ++position) {
+        if ((position == end) || (*position != ' ')) {
+            return position;
+        }
+    }
+    return scanKernels.skipSpaces(position, end);
+}
+
+inline const char* skipNameBytes(const char* position, const char* end) {
+    for (int i = 0; i < inlineScanLength; ++i, ++position) {
+        if (
+            (position == end) 
+            || (not hasCharacterClass(*position, CharacterClassName))
+        ) {
+            return position;
+        }
+    }
+    return scanKernels.skipNameBytes(position, end);
+}
+
+inline const char* findNewline(const char* position, const char* end) {
+    return scanKernels.findNewline(position, end);
+}
+
+inline const char* findStringSpecial(
+    const char* position, 
+    const char* end, 
+    char quote
+) {
+    for (int i = 0; i < inlineScanLength; ++i, ++position) {
+        if (position == end) {
+            return position;
+        }
+
+        char c = *position;
+        if ((c == quote) || (c == '\\') || (c == '\n')) {
+            return position;
+        }
+    }
+    return scanKernels.findStringSpecial(position, end, quote);
+}
+
+inline const char* findBlockSpecial(const char* position, const char* end) {
+    for (int i = 0; i < inlineScanLength; ++i, ++position) {
+        if ((position == end) || isBlockSpecial(*position)) {
+            return position;
+        }
+    }
+    return scanKernels.findBlockSpecial(position, end);
+}
+
+inline const char* findEscapeByte(
+    const char* position, 
+    const char* end, 
+    bool escapeHighBytes
+) {
+    for (int i = 0; i < inlineScanLength; ++i, ++position) {
+        if ((position == end) || needsEscape(*position, escapeHighBytes)) {
+            return position;
+        }
+    }
+    return scanKernels.findEscapeByte(position, end, escapeHighBytes);
+}
@@ -3,14 +3,132 @@
 #include <cassert>
 #include "token.h"
 
-TokenKind getKindOfWord(const std::string& value) {
-    if (auto it = stringTokenMap.find(value); 
-        it != std::end(stringTokenMap)) {
-        return it->second;
+constexpr TokenKind matchKeyword(
+    std::string_view value, 
+    std::string_view keyword, 
+    TokenKind kind
+) {
+    return value == keyword ? kind : TokenKind::Identifier;
+}
+
+// Switches on the length and the first character, so that at most two 
+// keywords are compared against. Must agree with 'stringTokenMap'.
+constexpr TokenKind getKindOfWord(std::string_view value) {
+    if (value.size() < 2) {
+        return TokenKind::Identifier;
+    }
+
+    switch (value.size()) {
+    case 2: {
+        switch (value[0]) {
+        case 'a': return matchKeyword(value, "as", TokenKind::KeywordAs);
+        case 'o': return matchKeyword(value, "or", TokenKind::ConditionalOr);
+        case 'i': {
+            switch (value[1]) {
+            case 'f': return TokenKind::KeywordIf;
+            case 'n': return TokenKind::RelationalIsContainedIn;
+            case 's': return TokenKind::RelationalIdentical;
+            }
+            break;
+        }
+        }
+        break;
+    }
+    case 3: {
+        switch (value[0]) {
+        case 'a': return matchKeyword(value, "and", TokenKind::ConditionalAnd);
+        case 'f': return matchKeyword(value, "for", TokenKind::KeywordFor);
+        case 'n': return matchKeyword(value, "not", TokenKind::ConditionalNot);
+        case 't': return matchKeyword(value, "try", TokenKind::KeywordTry);
+        case 'x': return matchKeyword(value, "xor", TokenKind::ConditionalXor);
+        case 'd': {
+            if (value[1] != 'e') {
+                break;
+            }
+            switch (value[2]) {
+            case 'f': return TokenKind::KeywordDef;
+            case 'l': return TokenKind::KeywordDel;
+            }
+            break;
+        }
+        }
+        break;
+    }
+    case 4: {
+        switch (value[0]) {
+        case 'N': return matchKeyword(value, "None", TokenKind::KeywordNone);
+        case 'T': 
+            return matchKeyword(value, "True", TokenKind::ConstantBooleanTrue);
+        case 'f': return matchKeyword(value, "from", TokenKind::KeywordFrom);
+        case 'p': return matchKeyword(value, "pass", TokenKind::KeywordPass);
+        case 'w': return matchKeyword(value, "with", TokenKind::KeywordWith);
+        case 'e': {
+            if (value == "elif") {
+                return TokenKind::KeywordElif;
+            }
+            return matchKeyword(value, "else", TokenKind::KeywordElse);
+        }
+        }
+        break;
+    }
+    case 5: {
+        switch (value[0]) {
+        case 'F': 
+            return matchKeyword(value, "False", TokenKind::ConstantBooleanFalse);
+        case 'a': return matchKeyword(value, "await", TokenKind::KeywordAwait);
+        case 'b': return matchKeyword(value, "break", TokenKind::KeywordBreak);
+        case 'c': return matchKeyword(value, "class", TokenKind::KeywordClass);
+        case 'r': return matchKeyword(value, "raise", TokenKind::KeywordRaise);
+        case 'w': return matchKeyword(value, "while", TokenKind::KeywordWhile);
+        case 'y': return matchKeyword(value, "yield", TokenKind::KeywordYield);
+        }
+        break;
+    }
+    case 6: {
+        switch (value[0]) {
+        case 'a': 
+            return matchKeyword(value, "assert", TokenKind::KeywordAssert);
+        case 'e': 
+            return matchKeyword(value, "except", TokenKind::KeywordExcept);
+        case 'g': 
+            return matchKeyword(value, "global", TokenKind::KeywordGlobal);
+        case 'i': 
+            return matchKeyword(value, "import", TokenKind::KeywordImport);
+        case 'l': 
+            return matchKeyword(value, "lambda", TokenKind::KeywordLambda);
+        case 'r': 
+            return matchKeyword(value, "return", TokenKind::KeywordReturn);
+        }
+        break;
+    }
+    case 7: {
+        return matchKeyword(value, "finally", TokenKind::KeywordFinally);
+    }
+    case 8: {
+        switch (value[0]) {
+        case 'c': 
+            return matchKeyword(value, "continue", TokenKind::KeywordContinue);
+        case 'n': 
+            return matchKeyword(value, "nonlocal", TokenKind::KeywordNonlocal);
+        }
+        break;
     }
+    }
+
     return TokenKind::Identifier;
 }
 
+static_assert(getKindOfWord("if") == TokenKind::KeywordIf);
+static_assert(getKindOfWord("is") == TokenKind::RelationalIdentical);
+static_assert(getKindOfWord("def") == TokenKind::KeywordDef);
+static_assert(getKindOfWord("elif") == TokenKind::KeywordElif);
+static_assert(getKindOfWord("else") == TokenKind::KeywordElse);
+static_assert(getKindOfWord("finally") == TokenKind::KeywordFinally);
+static_assert(getKindOfWord("nonlocal") == TokenKind::KeywordNonlocal);
+static_assert(getKindOfWord("deg") == TokenKind::Identifier);
+static_assert(getKindOfWord("i") == TokenKind::Identifier);
+static_assert(getKindOfWord("elifs") == TokenKind::Identifier);
+
 const char* toString(TokenKind kind) {
     switch (kind) {
     case TokenKind::None: return "<None>";
@@ -125,10 +243,31 @@ const char* toString(TokenKind kind) {
 }
 
 std::string toString(const Token& token) {
-    std::string value = "Token(value='" + token.value + "')";
+    std::string value = "Token(value='" + std::string(token.value) + "')";
     return value;
 }
 
+// the prefix letters of a string token, e.g. "rb" in rb'...'
+std::string_view getStringPrefix(const Token& token) {
+    return token.value.substr(0, token.value.find_first_of("'\""));
+}
+
+bool isBytesLiteral(const Token& token) {
+    return getStringPrefix(token).find_first_of("bB") != std::string_view::npos;
+}
+
+// the decoded text of a string token, without its prefix and quotes
+std::string_view getStringBody(const Token& token) {
+    size_t quoteLength = 
+        (token.kind == TokenKind::ConstantMultilineString) ? 3 : 1;
+    size_t start = getStringPrefix(token).size() + quoteLength;
+
+    return token.value.substr(
+        start, 
+        token.value.size() - start - quoteLength
+    );
+}
+
 bool isAssignment(TokenKind kind) {
     switch (kind) {
     case TokenKind::Assignment:
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <map>
 
 enum class TokenKind {
@@ -111,7 +112,7 @@ enum class TokenKind {
     AssignmentArithmeticAt,
 };
 
-const std::map<std::string, TokenKind> stringTokenMap = {
+const std::map<std::string, TokenKind, std::less<>> stringTokenMap = {
     { "True",     TokenKind::ConstantBooleanTrue },
     { "False",    TokenKind::ConstantBooleanFalse },
 
@@ -152,20 +153,102 @@ const std::map<std::string, TokenKind> stringTokenMap = {
     { "xor",      TokenKind::ConditionalXor },
 };
 
+// The text of a token is a view into the lexer's source buffer, so reading 
+// a token does not allocate. Only string literals that contain escape 
+// sequences own a decoded copy of their text.
 struct Token {
-    TokenKind kind;
-    size_t lineNumber;
-    size_t columnNumber;
-    std::string value;
+    Token() = default;
+
+    Token(const Token& other) {
+        *this = other;
+    }
+
+    Token& operator=(const Token& other) {
+        kind = other.kind;
+        lineNumber = other.lineNumber;
+        columnNumber = other.columnNumber;
+        offset = other.offset;
+        length = other.length;
+        virtualOffset = other.virtualOffset;
+        hasNamedEscape = other.hasNamedEscape;
+        decoded = other.decoded;
+        hasDecodedValue = other.hasDecodedValue;
+        value = hasDecodedValue ? std::string_view(decoded) : other.value;
+        return *this;
+    }
+
+    // takes over the decoded text, if any, instead of copying it
+    Token& operator=(Token&& other) {
+        kind = other.kind;
+        lineNumber = other.lineNumber;
+        columnNumber = other.columnNumber;
+        offset = other.offset;
+        length = other.length;
+        virtualOffset = other.virtualOffset;
+        hasNamedEscape = other.hasNamedEscape;
+        hasDecodedValue = other.hasDecodedValue;
+
+        if (hasDecodedValue) {
+            decoded = std::move(other.decoded);
+            value = decoded;
+        }
+        else {
+            value = other.value;
+        }
+
+        return *this;
+    }
+
+    TokenKind kind {TokenKind::None};
+    size_t lineNumber {0};
+    size_t columnNumber {0};
+
+    size_t offset {0}; // where the token starts in the source, in bytes
+    size_t length {0}; // how many source bytes the token covers
+
+    std::string_view value;
 
     int virtualOffset {0}; // offset from the beginning of the line.. 
 
+    // whether the literal has a \N{...} escape; the decoded text leaves 
+    // out the characters these name, since the lexer has no table of names
+    bool hasNamedEscape {false};
+
+    void setValue(std::string_view text) {
+        value = text;
+        hasDecodedValue = false;
+    }
+
+    // switches the token to owned storage, seeded with the given text
+    void beginDecoding(std::string_view text) {
+        decoded.assign(text.data(), text.size());
+        hasDecodedValue = true;
+        value = decoded;
+    }
+
+    bool isDecoded() const {
+        return hasDecodedValue;
+    }
+
     void appendCharacter(uint32_t val) {
-        GeniusC::AppendUtf8(value, val);
+        GeniusC::AppendUtf8(decoded, val);
+        value = decoded;
+    }
+
+    void appendText(std::string_view text) {
+        decoded.append(text.data(), text.size());
+        value = decoded;
     }
 
     void clear() {
-        value.clear();
+        value = {};
+        decoded.clear();
+        hasDecodedValue = false;
+        hasNamedEscape = false;
         virtualOffset = 0;
     }
+
+private:
+    std::string decoded;
+    bool hasDecodedValue {false};
 };
@@ -1,38 +1,33 @@
 #include <cstdio>
 #include <cassert>
 
-void quit();
-void quitIfErrorsWereMet();
-
 #include "common/common.h"
 #include "lexing/lexer.h"
 #include "ast/ast.h"
 #include "ast/to_src/to_src.h"
 #include "parsing/parser.cpp"
+#include "driver/driver.h"
+
+// Writes out the diagnostics of the run and ends the process.
+[[noreturn]] void quit(DiagnosticSession& session) {
+    session.print();
 
-void quit() {
     Console::write(
         "\nerrors: ", 
-        ErrorReporter::getNumberOfErrors(), 
+        session.getNumberOfErrors(), 
         ", "
     );
 
     Console::writeLine(
         "warnings: ", 
-        ErrorReporter::getNumberOfWarnings()
+        session.getNumberOfWarnings()
     );
 
-    exit(ErrorReporter::getNumberOfErrors());
-}
-
-void quitIfErrorsWereMet() {
-    if (ErrorReporter::getNumberOfErrors() > 0) {
-        quit();
-    }
+    exit(session.getNumberOfErrors());
 }
 
-void testLexer() {
-    Lexer lexer;
+void testLexer(Diagnostics& diagnostics) {
+    Lexer lexer(&diagnostics);
     assert(lexer.useFile("sample.py"));
 
     Token token;
@@ -44,21 +39,29 @@ void testLexer() {
     }
 }
 
-void testParser() {
-    Lexer lexer;
+void testParser(Diagnostics& diagnostics) {
+    Lexer lexer(&diagnostics);
     assert(lexer.useFile("sample.py"));
 
-    Parser parser(&lexer);
+    Arena arena;
+    Parser parser(&lexer, &arena, &diagnostics);
     std::vector<StmtPtr> statements;
 
     parser.parseStmtList(statements);
 }
 
-void testAstToSourceTransformer() {
-    Lexer lexer;
+// Transforms sample.py back to source, streaming the output to the file in 
+// chunks as it is made. With 'threadCount' set, the statements are 
+// transformed in parts on that many threads instead.
+void testAstToSourceTransformer(
+    Diagnostics& diagnostics, 
+    size_t threadCount
+) {
+    Lexer lexer(&diagnostics);
     assert(lexer.useFile("sample.py"));
 
-    Parser parser(&lexer);
+    Arena arena;
+    Parser parser(&lexer, &arena, &diagnostics);
     std::vector<StmtPtr> statements;
 
     parser.parseStmtList(statements);
@@ -66,24 +69,98 @@ void testAstToSourceTransformer() {
     std::ofstream fileStream("transformed_output.py");
     assert(fileStream.is_open());
 
-    PythonAstTransformer transformer;
+    OutputSink sink(fileStream);
+    SourceMap sourceMap;
+
+    if (threadCount == 0) {
+        PythonAstTransformer transformer;
+        transformer.setOutputSink(&sink);
+        transformer.setSourceMap(&sourceMap);
 
-    for (auto& stmt : statements) {
-        transformer.appendStmt(stmt);
+        for (auto stmt : statements) {
+            transformer.appendStmt(stmt);
+        }
+
+        transformer.flush();
+    }
+    else {
+        ThreadPool pool(threadCount);
+        transformModule(statements, sink, pool, false, &sourceMap);
     }
 
-    printToStream(fileStream, transformer.getBuffer());
     fileStream.close();
+
+    std::ofstream mapStream("transformed_output.py.map");
+    assert(mapStream.is_open());
+
+    OutputSink mapSink(mapStream);
+    sourceMap.write(mapSink);
+}
+
+void test(DiagnosticSession& session, size_t threadCount) {
+    Diagnostics diagnostics;
+
+    try {
+        //testLexer(diagnostics);
+        //testParser(diagnostics);
+        testAstToSourceTransformer(diagnostics, threadCount);
+    }
+    catch (const FatalError&) {}
+
+    session.publish("sample.py", std::move(diagnostics));
 }
 
-void test() {
-    //testLexer();
-    //testParser();
-    testAstToSourceTransformer();
+// pet [-j threads] path...
+// Parses every python file named, or found under a named directory, one 
+// module per file, spread over a pool of threads. With no paths, the 
+// sample is transformed on that many threads instead.
+void parseFiles(int argc, char const *argv[], DiagnosticSession& session) {
+    size_t threadCount = ThreadPool::defaultThreadCount();
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+
+        if ((argument == "-j" || argument == "--jobs") && i + 1 < argc) {
+            threadCount = std::max(1, std::atoi(argv[++i]));
+            continue;
+        }
+
+        paths.push_back(argument);
+    }
+
+    if (paths.empty()) {
+        test(session, threadCount);
+        return;
+    }
+
+    Diagnostics diagnostics;
+    auto files = collectSourceFiles(paths, diagnostics);
+    session.publish("", std::move(diagnostics));
+
+    auto modules = parseModules(files, session, threadCount);
+    size_t numberOfStatements = 0;
+
+    for (const auto& module : modules) {
+        numberOfStatements += module.statements.size();
+    }
+
+    Console::writeLine(
+        "parsed ", modules.size(), " files (", 
+        numberOfStatements, " top-level statements)"
+    );
 }
 
 int main(int argc, char const *argv[]) {
-    test();
-    quit();
+    DiagnosticSession session;
+
+    if (argc > 1) {
+        parseFiles(argc, argv, session);
+    }
+    else {
+        test(session, 0);
+    }
+
+    quit(session);
     return 0;
 }
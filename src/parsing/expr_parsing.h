@@ -3,11 +3,11 @@
 // @todo: inline all functions that arent recursive
 
 ExprPtr Parser::parseYieldExpr() {
-    auto expr = std::make_shared<YieldExpr>(currentLocation);
+    auto expr = arena->make<YieldExpr>(currentLocation);
     fetchToken();
 
-    if (linesChanged) {
-        return expr;
+    if (atEndOfSimpleStmt()) {
+        return endNode(expr);
     }
 
     if (skipOptionalToken(TokenKind::KeywordFrom)) {
@@ -19,95 +19,121 @@ ExprPtr Parser::parseYieldExpr() {
         } while (skipOptionalToken(TokenKind::Comma));
     }
 
-    return expr;
+    return endNode(expr);
 }
 
 ExprPtr Parser::parseTopExpr() {
-    switch (currentToken.kind) {
+    switch (currentToken->kind) {
     case TokenKind::Identifier: {
-        auto expr = std::make_shared<NameExpr>(currentLocation);
-        expr->value = currentToken.value;
+        auto expr = arena->make<NameExpr>(currentLocation);
+        expr->value = currentToken->value;
         fetchToken();
-        return expr;
+        return endNode(expr);
     }
     case TokenKind::KeywordNone: {
-        auto expr = std::make_shared<Expr>(currentLocation, ExprKind::None);
+        auto expr = arena->make<Expr>(currentLocation, ExprKind::None);
         fetchToken();
-        return expr;
+        return endNode(expr);
     }
-    case TokenKind::ConstantMultilineString: {
-        auto expr = std::make_shared<StringLiteralExpr>(currentLocation);
-        expr->value = "";
+    case TokenKind::ConstantMultilineString:
+    case TokenKind::ConstantString: {
+        auto expr = arena->make<StringLiteralExpr>(currentLocation);
+        expr->isBytes = isBytesLiteral(*currentToken);
+
+        // the literals as written, joined by spaces; only kept when one of 
+        // them has an escape the value could not be decoded from
+        bool hasNamedEscape = false;
+        std::string_view firstWritten;
+        std::string written;
 
         do {
-            expr->value += currentToken.value.substr(3, currentToken.value.size() - 6);
-            fetchToken();
-        } while (matchToken(TokenKind::ConstantString) || matchToken(TokenKind::ConstantMultilineString));
+            if (isBytesLiteral(*currentToken) != expr->isBytes) {
+                diagnostics->reportFatalError(
+                    "cannot join bytes and non-bytes literals",
+                    currentLocation
+                );
+            }
 
-        return expr;
-    }
-    case TokenKind::ConstantString: {
-        auto expr = std::make_shared<StringLiteralExpr>(currentLocation);
-        expr->value = "";
+            auto text = lexer->getSource().substr(
+                currentToken->offset, 
+                currentToken->length
+            );
 
-        do {
-            expr->value += currentToken.value.substr(1, currentToken.value.size() - 2);
+            if (firstWritten.empty()) {
+                firstWritten = text;
+            }
+            else {
+                if (written.empty()) {
+                    written = firstWritten;
+                }
+                written += ' ';
+                written += text;
+            }
+
+            hasNamedEscape = hasNamedEscape || currentToken->hasNamedEscape;
+            expr->value += getStringBody(*currentToken);
             fetchToken();
         } while (matchToken(TokenKind::ConstantString) || matchToken(TokenKind::ConstantMultilineString));
 
-        return expr;
+        if (hasNamedEscape) {
+            expr->text = written.empty() ? std::string(firstWritten) : written;
+        }
+
+        return endNode(expr);
     }
     case TokenKind::ConstantBooleanTrue: {
-        auto expr = std::make_shared<BooleanLiteralExpr>(currentLocation);
+        auto expr = arena->make<BooleanLiteralExpr>(currentLocation);
         expr->value = true;
         fetchToken();
-        return expr;
+        return endNode(expr);
     }
     case TokenKind::ConstantBooleanFalse: {
-        auto expr = std::make_shared<BooleanLiteralExpr>(currentLocation);
+        auto expr = arena->make<BooleanLiteralExpr>(currentLocation);
         expr->value = false;
         fetchToken();
-        return expr;
+        return endNode(expr);
     }
     case TokenKind::ConstantInteger: {
-        auto expr = std::make_shared<IntegerLiteralExpr>(currentLocation);
-        try {
-            expr->value = std::stoll(currentToken.value);
-        }
-        catch (...) {
-            ErrorReporter::reportFatalError(
-                "invalid integer literal",
-                currentLocation
-            );
+        auto expr = arena->make<IntegerLiteralExpr>(currentLocation);
+
+        // literals too big for 64 bits are kept as written, and so are 
+        // malformed ones, which the lexer has reported already
+        if (
+            parseIntegerLiteral(currentToken->value, expr->value) 
+            != NumberStatus::Ok
+        ) {
+            expr->text = currentToken->value;
         }
+
         fetchToken();
-        return expr;
+        return endNode(expr);
     }
-    case TokenKind::ConstantFloat: {
-        auto expr = std::make_shared<FloatLiteralExpr>(currentLocation);
-        try {
-            expr->value = std::stold(currentToken.value);
-        }
-        catch (...) {
-            ErrorReporter::reportFatalError(
+    case TokenKind::ConstantFloat:
+    case TokenKind::ConstantImaginary: {
+        auto expr = arena->make<FloatLiteralExpr>(currentLocation);
+        expr->isImaginary = matchToken(TokenKind::ConstantImaginary);
+
+        if (
+            parseFloatLiteral(currentToken->value, expr->value) 
+            != NumberStatus::Ok
+        ) {
+            diagnostics->reportFatalError(
                 "invalid float literal",
                 currentLocation
             );
         }
+
         fetchToken();
-        return expr;
-    }
-    case TokenKind::ConstantImaginary: {
-        assert(0);
+        return endNode(expr);
     }
     case TokenKind::KeywordYield: {
         return parseYieldExpr();
     }
     default:
-        ErrorReporter::reportFatalError(
+        diagnostics->reportFatalError(
             formatAsString(
                 "expected an expression here, but got: ",
-                currentToken.value
+                currentToken->value
             ),
             currentLocation
         );
@@ -117,16 +143,16 @@ ExprPtr Parser::parseTopExpr() {
 }
 
 ExprPtr Parser::parseListDisplayExpr() {
-    auto expr = std::make_shared<ListDisplayExpr>(currentLocation);
+    auto expr = arena->make<ListDisplayExpr>(currentLocation);
     fetchToken(); // skip "["
 
     if (skipOptionalToken(TokenKind::ClosingSquareBracket)) {
-        return expr;
+        return endNode(expr);
     }
     auto first = parseExpr();
 
     if (matchToken("for") || matchToken("async")) {
-        auto comprehension = std::make_shared<Comprehension>();
+        auto comprehension = arena->make<Comprehension>();
         comprehension->expr = first;
         comprehension->compFor = parseComprehensionFor();
 
@@ -138,7 +164,7 @@ ExprPtr Parser::parseListDisplayExpr() {
 
         if (not skipOptionalToken(TokenKind::Comma)) {
             skipRequiredToken(TokenKind::ClosingSquareBracket);
-            return expr;
+            return endNode(expr);
         }
 
         while (not skipOptionalToken(TokenKind::ClosingSquareBracket)) {
@@ -150,7 +176,7 @@ ExprPtr Parser::parseListDisplayExpr() {
         }
     }
 
-    return expr;
+    return endNode(expr);
 }
 
 ExprPtr Parser::parseParenthesizedExpr() {
@@ -177,14 +203,14 @@ ExprPtr Parser::parseParenthesizedExpr() {
                 break;
             }
 
-            auto expr = std::make_shared<GeneratorExpr>(currentLocation);
+            auto expr = arena->make<GeneratorExpr>(currentLocation);
             expr->expr = list.front();
             expr->compFor = parseComprehensionFor();
 
             skipRequiredToken(TokenKind::ClosingRoundBracket);
 
             this->parsingParenthesizedExpr = false;
-            return expr;
+            return endNode(expr, location.offset);
         }
 
         danglingComma = true;
@@ -193,7 +219,7 @@ ExprPtr Parser::parseParenthesizedExpr() {
     this->parsingParenthesizedExpr = false;
 
     if (danglingComma) {
-        auto noneExpr = std::make_shared<Expr>(
+        auto noneExpr = arena->make<Expr>(
             currentLocation, 
             ExprKind::None
         );
@@ -202,19 +228,21 @@ ExprPtr Parser::parseParenthesizedExpr() {
     }
 
     if (list.size() == 0) {
-        ErrorReporter::reportFatalError(
+        diagnostics->reportFatalError(
             "empty paretheses not allowed",
             location
         );
     }
     else if (list.size() > 1) {
         // tuple
-        auto expr = std::make_shared<TupleDisplayExpr>(location);
+        auto expr = arena->make<TupleDisplayExpr>(location);
         expr->items = std::move(list);
-        return expr;
+        return endNode(expr);
     }
     else {
-        return list.front();
+        // the range takes in the brackets, so that the expression can be 
+        // copied into any context as it was written
+        return endNode(list.front(), location.offset);
     }
 
     return nullptr;
@@ -252,21 +280,21 @@ ExprPtr Parser::parseCurlyBracketDisplayExpr() {
     fetchToken();
 
     if (skipOptionalToken(TokenKind::ClosingCurlyBracket)) {
-        return std::make_shared<SetDisplayExpr>(std::move(location));
+        return endNode(arena->make<SetDisplayExpr>(std::move(location)));
     }
 
     auto temp = parseExpr();
 
     if (matchToken("async") || matchToken("for")) {
-        auto expr = std::make_shared<SetDisplayExpr>(std::move(location));
+        auto expr = arena->make<SetDisplayExpr>(std::move(location));
         
-        auto comprehension = std::make_shared<Comprehension>();
+        auto comprehension = arena->make<Comprehension>();
         comprehension->expr = temp;
         comprehension->compFor = parseComprehensionFor();
 
         expr->comprehension = comprehension;
         skipRequiredToken(TokenKind::ClosingCurlyBracket);            
-        return expr;
+        return endNode(expr);
     }
 
     if (skipOptionalToken(TokenKind::Colon)) {
@@ -280,15 +308,15 @@ ExprPtr Parser::parseCurlyBracketDisplayExpr() {
             firstItem.compFor = parseComprehensionFor();
             skipRequiredToken(TokenKind::ClosingCurlyBracket);
 
-            auto expr = std::make_shared<DictDisplayExpr>(
+            auto expr = arena->make<DictDisplayExpr>(
                 std::move(location)
             );
 
             expr->itemList.push_back(std::move(firstItem));
-            return expr;
+            return endNode(expr);
         }
 
-        auto expr = std::make_shared<DictDisplayExpr>(std::move(location));
+        auto expr = arena->make<DictDisplayExpr>(std::move(location));
         expr->itemList.push_back(std::move(firstItem));
 
         if (skipOptionalToken(TokenKind::Comma)) {
@@ -298,37 +326,37 @@ ExprPtr Parser::parseCurlyBracketDisplayExpr() {
             skipRequiredToken(TokenKind::ClosingCurlyBracket);
         }
 
-        return expr;
+        return endNode(expr);
     }
     else if (skipOptionalToken(TokenKind::Comma)) {
         // this is a set display
-        auto expr = std::make_shared<SetDisplayExpr>(std::move(location));
+        auto expr = arena->make<SetDisplayExpr>(std::move(location));
 
         if (matchToken("async") || matchToken("for")) {
-            auto comprehension = std::make_shared<Comprehension>();
+            auto comprehension = arena->make<Comprehension>();
             comprehension->expr = temp;
             comprehension->compFor = parseComprehensionFor();
 
             expr->comprehension = comprehension;
             skipRequiredToken(TokenKind::ClosingCurlyBracket);
-            return expr;
+            return endNode(expr);
         }
 
         expr->items.push_back(temp);
         parseSetDisplayExpr(*expr);
 
-        return expr;
+        return endNode(expr);
     }
     else if (skipOptionalToken(TokenKind::ClosingCurlyBracket)) {
-        auto expr = std::make_shared<SetDisplayExpr>(std::move(location));
+        auto expr = arena->make<SetDisplayExpr>(std::move(location));
         expr->items.push_back(temp);
-        return expr;
+        return endNode(expr);
     }
     else {
-        ErrorReporter::reportFatalError(
+        diagnostics->reportFatalError(
             formatAsString(
                 "expected either ':', or '}', but found: ",
-                currentToken.value
+                currentToken->value
             ),
             currentLocation
         );
@@ -355,8 +383,10 @@ ExprPtr Parser::parseDisplayExpr() {
 }
 
 TargetPtr Parser::parseTarget() {
+    NestingGuard guard(this);
+
     if (skipOptionalToken(TokenKind::OpeningRoundBracket)) {
-        auto target = std::make_shared<BrackettedTarget>();
+        auto target = arena->make<BrackettedTarget>();
         target->bracketKind = TokenKind::OpeningRoundBracket;
 
         do {
@@ -370,7 +400,7 @@ TargetPtr Parser::parseTarget() {
         return target;
     }
     else if (skipOptionalToken(TokenKind::ClosingSquareBracket)) {
-        auto target = std::make_shared<BrackettedTarget>();
+        auto target = arena->make<BrackettedTarget>();
         target->bracketKind = TokenKind::OpeningSquareBracket;
 
         do {
@@ -384,16 +414,16 @@ TargetPtr Parser::parseTarget() {
         return target;
     }
     
-    std::shared_ptr<ExprTarget> target;
+    ExprTarget* target;
     Location targetLocation = currentLocation;
 
     if (skipOptionalToken(TokenKind::ArithmeticMul)) {
-        target = std::make_shared<ExprTarget>();
+        target = arena->make<ExprTarget>();
         target->expr = parseSliceCallAttrSubsExpr();
         target->stars = 1;
     }
     else {
-        target = std::make_shared<ExprTarget>();
+        target = arena->make<ExprTarget>();
         target->expr = parseSliceCallAttrSubsExpr();
         target->stars = 0;
     }
@@ -406,7 +436,7 @@ TargetPtr Parser::parseTarget() {
         break;
     }
     default:
-        ErrorReporter::reportFatalError(
+        diagnostics->reportFatalError(
             "invalid target",
             targetLocation
         );
@@ -416,7 +446,7 @@ TargetPtr Parser::parseTarget() {
 }
 
 CompIterPtr Parser::parseComprehensionIter() {
-    auto compIter = std::make_shared<CompIter>();
+    auto compIter = arena->make<CompIter>();
     compIter->compFor = parseComprehensionFor();
 
     if (matchToken("async") || matchToken("for")) {
@@ -430,7 +460,8 @@ CompIterPtr Parser::parseComprehensionIter() {
 }
 
 CompForPtr Parser::parseComprehensionFor() {
-    auto compFor = std::make_shared<CompFor>();
+    NestingGuard guard(this);
+    auto compFor = arena->make<CompFor>();
 
     if (skipOptionalToken("async")) {
         compFor->isAsync = true;
@@ -455,7 +486,7 @@ CompForPtr Parser::parseComprehensionFor() {
         compFor->compIter = parseComprehensionIter();
     }
     else if (matchToken("if")) {
-        auto compIter = std::make_shared<CompIter>();
+        auto compIter = arena->make<CompIter>();
         compIter->compIf = parseComprehensionIf();
     }
 
@@ -463,7 +494,7 @@ CompForPtr Parser::parseComprehensionFor() {
 }
 
 CompIfPtr Parser::parseComprehensionIf() {
-    auto compIf = std::make_shared<CompIf>();
+    auto compIf = arena->make<CompIf>();
     fetchToken(); // skip "if"
 
     compIf->exprNoCond = parseBooleanOrExpr();
@@ -480,14 +511,14 @@ CompIfPtr Parser::parseComprehensionIf() {
 }
 
 ComprehensionPtr Parser::parseComprehension() {
-    auto comprehension = std::make_shared<Comprehension>();
+    auto comprehension = arena->make<Comprehension>();
     comprehension->expr = parseExpr();
     comprehension->compFor = parseComprehensionFor();
     return comprehension;
 }
 
 ExprPtr Parser::parseCallExpr(ExprPtr left) {
-    auto expr = std::make_shared<CallExpr>(left->location);
+    auto expr = arena->make<CallExpr>(left->location);
     expr->primary = left;
 
     // @note: This doesn't take into account the ordering of the 
@@ -518,7 +549,7 @@ ExprPtr Parser::parseCallExpr(ExprPtr left) {
                     || matchToken("async")
                 )
             ) {
-                expr->comprehension = std::make_shared<Comprehension>();
+                expr->comprehension = arena->make<Comprehension>();
                 expr->comprehension->expr = tempArgument;
                 expr->comprehension->compFor = parseComprehensionFor();
                 skipRequiredToken(TokenKind::ClosingRoundBracket);
@@ -526,20 +557,20 @@ ExprPtr Parser::parseCallExpr(ExprPtr left) {
             }
             else if (matchToken("=")) {
                 if (tempArgument->kind != ExprKind::Name) {
-                    ErrorReporter::reportFatalError(
+                    diagnostics->reportFatalError(
                         "unexpected '=' after non-name expression",
                         currentLocation
                     );
                 }
 
                 if (tempArgument->await) {
-                    ErrorReporter::reportFatalError(
+                    diagnostics->reportFatalError(
                         "unexpected '=' after non-name expression",
                         currentLocation
                     );
                 }
 
-                argument.name = std::static_pointer_cast<NameExpr>(
+                argument.name = static_cast<NameExpr*>(
                     tempArgument
                 )->value;
 
@@ -560,7 +591,7 @@ ExprPtr Parser::parseCallExpr(ExprPtr left) {
         }
     }
 
-    return expr;
+    return endNode(expr, left->range.begin);
 }
 
 void Parser::parseSliceStride(SlicingExpr& slice) {
@@ -593,7 +624,7 @@ void Parser::parseSliceUpperbound(SlicingExpr& slice) {
 ExprPtr Parser::parseSliceOrSubscription(ExprPtr left) {
     if (skipOptionalToken(TokenKind::Colon)) {
         // it's a slice
-        auto expr = std::make_shared<SlicingExpr>(
+        auto expr = arena->make<SlicingExpr>(
             left->location
         );
 
@@ -601,13 +632,13 @@ ExprPtr Parser::parseSliceOrSubscription(ExprPtr left) {
         expr->lowerBound = nullptr;
 
         parseSliceUpperbound(*expr);
-        return expr;
+        return endNode(expr, left->range.begin);
     }
     else {
         auto firstExpr = parseExpr();
         if (skipOptionalToken(TokenKind::Colon)) {
             // slice
-            auto expr = std::make_shared<SlicingExpr>(left->location);
+            auto expr = arena->make<SlicingExpr>(left->location);
 
             expr->primary = left;
             expr->lowerBound = firstExpr;
@@ -616,11 +647,11 @@ ExprPtr Parser::parseSliceOrSubscription(ExprPtr left) {
                 parseSliceUpperbound(*expr);
             }
 
-            return expr;
+            return endNode(expr, left->range.begin);
         }
         else {
             // subcription
-            auto expr = std::make_shared<SubscriptionExpr>(
+            auto expr = arena->make<SubscriptionExpr>(
                 left->location
             );
 
@@ -637,7 +668,7 @@ ExprPtr Parser::parseSliceOrSubscription(ExprPtr left) {
                 }
             }
 
-            return expr;
+            return endNode(expr, left->range.begin);
         }
     }
 }
@@ -645,27 +676,35 @@ ExprPtr Parser::parseSliceOrSubscription(ExprPtr left) {
 // @todo: clean this thing up.. it's pathetically disgusting
 ExprPtr Parser::parseSliceCallAttrSubsExpr() {
     auto expr = parseDisplayExpr();
+
+    // every link of the chain nests what came before it one level deeper
+    NestingGuard guard(this, 0);
+
     while (1) {
-        switch (currentToken.kind) {
+        switch (currentToken->kind) {
         case TokenKind::Access: {
-            auto temp = std::make_shared<AttributeRefExpr>(expr->location);
+            guard.enter();
+
+            auto temp = arena->make<AttributeRefExpr>(expr->location);
             temp->primary = expr;
 
             fetchToken();
 
             requireToken(TokenKind::Identifier);
-            temp->name = currentToken.value;
+            temp->name = currentToken->value;
             fetchToken();
 
-            expr = temp;
+            expr = endNode(temp, temp->primary->range.begin);
             continue;
         }
         case TokenKind::OpeningRoundBracket: {
+            guard.enter();
             fetchToken();
             expr = parseCallExpr(expr);
             continue;
         }
         case TokenKind::OpeningSquareBracket: {
+            guard.enter();
             fetchToken();
             expr = parseSliceOrSubscription(expr);
             break;
@@ -690,219 +729,87 @@ ExprPtr Parser::parseAwaitExpr() {
     return expr;
 }
 
-ExprPtr Parser::parseExponentiationExpr() {
-    auto expr = parseAwaitExpr();
-    while (matchToken(TokenKind::ArithmeticPow)) {
-        auto temp = std::make_shared<BinaryExpr>(expr->location);
-        temp->lhs = expr;
-        temp->op = currentToken.kind;
-
-        fetchToken();
-
-        temp->rhs = parseAwaitExpr();
-        expr = temp;
+// of the current token, as a binary operator
+BindingPower Parser::getBinaryBindingPower() const {
+    // a '@' that starts a line is a decorator, not matrix multiplication
+    if (linesChanged && matchToken(TokenKind::At)) {
+        return BindingPower::None;
     }
-    return expr;
-}
-
-ExprPtr Parser::parseUnaryExpr() {
-    switch (currentToken.kind) {
-    case TokenKind::LogicalNot:
-    case TokenKind::ArithmeticAdd:
-    case TokenKind::ArithmeticSub: {
-        auto expr = std::make_shared<UnaryExpr>(currentLocation);
-        expr->op = currentToken.kind;
 
-        fetchToken();
-
-        expr->expr = parseExponentiationExpr();
-        return expr;
-    }
-    default:
-        return parseExponentiationExpr();
-    }
+    return binaryBindingPowers[static_cast<size_t>(currentToken->kind)];
 }
 
-ExprPtr Parser::parseMultiplicativeExpr() {
-    auto expr = parseUnaryExpr();
-    while (
-        matchToken(TokenKind::ArithmeticMul)
-        || matchToken(TokenKind::ArithmeticDiv)
-        || matchToken(TokenKind::ArithmeticFloorDiv)
-        || matchToken(TokenKind::ArithmeticMod)
-        || ((not linesChanged) && matchToken(TokenKind::At)) // matrix multiplication
-    ) {
-        auto temp = std::make_shared<BinaryExpr>(expr->location);
-        temp->lhs = expr;
-        temp->op = currentToken.kind;
-
-        fetchToken();
-
-        temp->rhs = parseUnaryExpr();
-        expr = temp;
-    }
-    return expr;
-}
+// Parses the operators that bind at least as tightly as 'minPower', by 
+// precedence climbing: an operand, then every binary operator strong 
+// enough, each with a right operand that only takes stronger operators.
+ExprPtr Parser::parseOperatorExpr(BindingPower minPower) {
+    ExprPtr expr;
 
-ExprPtr Parser::parseAdditiveExpr() {
-    auto expr = parseMultiplicativeExpr();
-    while (
-        matchToken(TokenKind::ArithmeticAdd)
-        || matchToken(TokenKind::ArithmeticSub)
+    if (
+        (minPower <= BindingPower::Not) 
+        && matchToken(TokenKind::ConditionalNot)
     ) {
-        auto temp = std::make_shared<BinaryExpr>(expr->location);
-        temp->lhs = expr;
-        temp->op = currentToken.kind;
+        auto temp = arena->make<UnaryExpr>(currentLocation);
+        temp->op = currentToken->kind;
 
         fetchToken();
 
-        temp->rhs = parseMultiplicativeExpr();
-        expr = temp;
+        temp->expr = parseOperatorExpr(BindingPower::Comparison);
+        expr = endNode(temp);
     }
-    return expr;
-}
-
-ExprPtr Parser::parseShiftExpr() {
-    auto expr = parseAdditiveExpr();
-    while (
-        matchToken(TokenKind::LogicalLeftShift)
-        || matchToken(TokenKind::LogicalRightShift)
+    else if (
+        (minPower <= BindingPower::Unary) 
+        && (
+            matchToken(TokenKind::LogicalNot)
+            || matchToken(TokenKind::ArithmeticAdd)
+            || matchToken(TokenKind::ArithmeticSub)
+        )
     ) {
-        auto temp = std::make_shared<BinaryExpr>(expr->location);
-        temp->lhs = expr;
-        temp->op = currentToken.kind;
+        auto temp = arena->make<UnaryExpr>(currentLocation);
+        temp->op = currentToken->kind;
 
         fetchToken();
 
-        temp->rhs = parseAdditiveExpr();
-        expr = temp;
+        temp->expr = parseOperatorExpr(BindingPower::Power);
+        expr = endNode(temp);
     }
-    return expr;
-}
-
-ExprPtr Parser::parseBitwiseAndExpr() {
-    auto expr = parseShiftExpr();
-    while (matchToken(TokenKind::LogicalAnd)) {
-        auto temp = std::make_shared<BinaryExpr>(expr->location);
-        temp->lhs = expr;
-        temp->op = currentToken.kind;
-
-        fetchToken();
-
-        temp->rhs = parseShiftExpr();
-        expr = temp;
-    }
-    return expr;
-}
-
-ExprPtr Parser::parseBitwiseXorExpr() {
-    auto expr = parseBitwiseAndExpr();
-    while (matchToken(TokenKind::LogicalXor)) {
-        auto temp = std::make_shared<BinaryExpr>(expr->location);
-        temp->lhs = expr;
-        temp->op = currentToken.kind;
-
-        fetchToken();
-
-        temp->rhs = parseBitwiseAndExpr();
-        expr = temp;
-    }
-    return expr;
-}
-
-ExprPtr Parser::parseBitwiseOrExpr() {
-    auto expr = parseBitwiseXorExpr();
-    while (matchToken(TokenKind::LogicalOr)) {
-        auto temp = std::make_shared<BinaryExpr>(expr->location);
-        temp->lhs = expr;
-        temp->op = currentToken.kind;
-
-        fetchToken();
-
-        temp->rhs = parseBitwiseXorExpr();
-        expr = temp;
+    else {
+        expr = parseAwaitExpr();
     }
-    return expr;
-}
 
-// @note @todo Make the lexer recognize tokens like "is not"
-ExprPtr Parser::parseComparisonExpr() {
-    auto expr = parseBitwiseOrExpr();
+    // whether 'expr' is a comparison made by this loop, which a comparison 
+    // after it chains on to
+    bool endsInComparison = false;
 
     while (1) {
-        switch (currentToken.kind) {
-        case TokenKind::RelationalEquals:
-        case TokenKind::RelationalNotEqual:
-        case TokenKind::RelationalIdentical:
-        case TokenKind::RelationalNotIdentical:
-        case TokenKind::RelationalGreaterThan:
-        case TokenKind::RelationalGreaterThanOrEquals:
-        case TokenKind::RelationalLesserThan:
-        case TokenKind::RelationalLesserThanOrEquals:
-        case TokenKind::RelationalIsContainedIn:
-        case TokenKind::RelationalIsNotContainedIn: {
-            auto temp = std::make_shared<BinaryExpr>(expr->location);
-
-            temp->lhs = expr;
-            temp->op = currentToken.kind;
-
-            fetchToken();
-
-            temp->rhs = parseBitwiseOrExpr();
-            expr = temp;
+        auto power = getBinaryBindingPower();
 
-            continue;
-        }
-        default:
+        if ((power == BindingPower::None) || (power < minPower)) {
             return expr;
         }
-    }
-
-    return expr;
-}
 
-ExprPtr Parser::parseBooleanNotExpr() {
-    if (not matchToken(TokenKind::ConditionalNot)) {
-        return parseComparisonExpr();
-    }
-
-    auto expr = std::make_shared<UnaryExpr>(currentLocation);
-    expr->op = currentToken.kind;
-
-    fetchToken();
-
-    expr->expr = parseComparisonExpr();
-    return expr;
-}
-
-ExprPtr Parser::parseBooleanAndExpr() {
-    auto expr = parseBooleanNotExpr();
-    while (matchToken(TokenKind::ConditionalAnd)) {
-        auto temp = std::make_shared<BinaryExpr>(expr->location);
+        auto temp = arena->make<BinaryExpr>(expr->location);
         temp->lhs = expr;
-        temp->op = currentToken.kind;
+        temp->op = currentToken->kind;
+        temp->continuesChain = endsInComparison 
+            && (power == BindingPower::Comparison);
+        endsInComparison = (power == BindingPower::Comparison);
 
         fetchToken();
 
-        temp->rhs = parseBooleanNotExpr();
-        expr = temp;
+        // the right operand of '**' may be signed and groups to the right, 
+        // so a ** -b ** c is a ** (-(b ** c))
+        temp->rhs = parseOperatorExpr(
+            (power == BindingPower::Power) 
+                ? BindingPower::Unary 
+                : static_cast<BindingPower>(static_cast<int>(power) + 1)
+        );
+        expr = endNode(temp, temp->lhs->range.begin);
     }
-    return expr;
 }
 
 ExprPtr Parser::parseBooleanOrExpr() {
-    auto expr = parseBooleanAndExpr();
-    while (matchToken(TokenKind::ConditionalOr)) {
-        auto temp = std::make_shared<BinaryExpr>(expr->location);
-        temp->lhs = expr;
-        temp->op = currentToken.kind;
-
-        fetchToken();
-
-        temp->rhs = parseBooleanAndExpr();
-        expr = temp;
-    }
-    return expr;
+    return parseOperatorExpr(BindingPower::Or);
 }
 
 ExprPtr Parser::parseLambdaExpr() {
@@ -913,20 +820,20 @@ ExprPtr Parser::parseLambdaExpr() {
             (parsingParenthesizedExpr || not linesChanged) 
             && skipOptionalToken(TokenKind::KeywordIf)
         ) {
-            auto temp = std::make_shared<IfExpr>(expr->location);
+            auto temp = arena->make<IfExpr>(expr->location);
             temp->cond = parseBooleanOrExpr();
             temp->thenValue = expr;
 
             skipRequiredToken(TokenKind::KeywordElse);
 
             temp->elseValue = parseBooleanOrExpr();
-            expr = temp;
+            expr = endNode(temp, temp->thenValue->range.begin);
         }
 
         return expr;
     }
 
-    auto expr = std::make_shared<LambdaExpr>(currentLocation);
+    auto expr = arena->make<LambdaExpr>(currentLocation);
     fetchToken();
 
     if (not skipOptionalToken(TokenKind::Colon)) {
@@ -953,9 +860,10 @@ ExprPtr Parser::parseLambdaExpr() {
     }
 
     expr->expr = parseExpr();
-    return expr;
+    return endNode(expr);
 }
 
 ExprPtr Parser::parseExpr() {
+    NestingGuard guard(this);
     return parseLambdaExpr();
 }
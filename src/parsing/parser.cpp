@@ -2,11 +2,11 @@
 #include "parser.h"
 
 bool Parser::matchToken(TokenKind kind) const {
-    return currentToken.kind == kind;
+    return currentToken->kind == kind;
 }
 
-bool Parser::matchToken(const std::string& value) const {
-    return currentToken.value == value;
+bool Parser::matchToken(std::string_view value) const {
+    return currentToken->value == value;
 }
 
 bool Parser::skipOptionalToken(TokenKind kind) {
@@ -17,7 +17,7 @@ bool Parser::skipOptionalToken(TokenKind kind) {
     return false;
 }
 
-bool Parser::skipOptionalToken(const std::string& value) {
+bool Parser::skipOptionalToken(std::string_view value) {
     if (matchToken(value)) {
         fetchToken();
         return true;
@@ -30,28 +30,28 @@ void Parser::requireToken(TokenKind kind) const {
         return;
     }
 
-    ErrorReporter::reportFatalError(
+    diagnostics->reportFatalError(
         formatAsString(
             "required '",
             toString(kind),
             "', but found: ",
-            currentToken.value
+            currentToken->value
         ),
         currentLocation
     );
 }
 
-void Parser::requireToken(const std::string& value) const {
+void Parser::requireToken(std::string_view value) const {
     if (matchToken(value)) {
         return;
     }
 
-    ErrorReporter::reportFatalError(
+    diagnostics->reportFatalError(
         formatAsString(
             "required '",
             value,
             "', but found: ",
-            currentToken.value
+            currentToken->value
         ),
         currentLocation
     );
@@ -62,66 +62,87 @@ void Parser::skipRequiredToken(TokenKind kind) {
     fetchToken();
 }
 
-void Parser::skipRequiredToken(const std::string& value) {
+void Parser::skipRequiredToken(std::string_view value) {
     requireToken(value);
     fetchToken();
 }
 
 std::string Parser::parseName() {
     requireToken(TokenKind::Identifier);
-    std::string value = currentToken.value;
+    std::string value(currentToken->value);
     fetchToken();
     return value;
 }
 
-Token& Parser::fetchToken() {
-    if (not tokenBuffer.empty()) {
-        currentToken = tokenBuffer.back();
-        tokenBuffer.pop_back();
-    }
-    else {
-        lexer->readToken(currentToken);
+void Parser::reportNestingTooDeep() const {
+    diagnostics->reportFatalError(
+        formatAsString(
+            "nested more than ",
+            maxNestingDepth,
+            " levels deep"
+        ),
+        currentLocation
+    );
+}
+
+// Reads a token from the lexer into one of the slots ahead of the current 
+// token, keeping count of the brackets opened and closed.
+void Parser::readToken(Token& token) {
+    lexer->readToken(token);
+
+    switch (token.kind) {
+    case TokenKind::OpeningRoundBracket:
+    case TokenKind::OpeningSquareBracket:
+    case TokenKind::OpeningCurlyBracket:
+        bracketDepth++;
+        break;
+    case TokenKind::ClosingRoundBracket:
+    case TokenKind::ClosingSquareBracket:
+    case TokenKind::ClosingCurlyBracket:
+        bracketDepth--;
+        break;
+    default:
+        break;
     }
+}
 
-    if (matchToken(TokenKind::ConditionalNot)) {
-        Token temp = currentToken;
-        fetchToken();
+const Token& Parser::peekToken(size_t distance) {
+    assert(distance < lookaheadCapacity);
 
-        if (matchToken(TokenKind::RelationalIsContainedIn)) {
-            currentToken.kind = TokenKind::RelationalIsNotContainedIn;
-            currentToken.value = "not in";
-        }
-        else {
-            tokenBuffer.push_back(currentToken);
-            currentToken = temp;
-        }
+    while (lookaheadCount < distance) {
+        lookaheadCount++;
+        readToken(tokens[(currentIndex + lookaheadCount) % lookaheadCapacity]);
     }
-    else if (matchToken(TokenKind::RelationalIdentical)) {
-        Token temp = currentToken;
-        fetchToken();
 
-        if (matchToken(TokenKind::ConditionalNot)) {
-            currentToken.kind = TokenKind::RelationalNotIdentical;
-            currentToken.value = "is not";
-        }
-        else {
-            tokenBuffer.push_back(currentToken);
-            currentToken = temp;
-        }
-    }
+    return tokens[(currentIndex + distance) % lookaheadCapacity];
+}
+
+Token& Parser::fetchToken() {
+    auto previousKind = currentToken->kind;
+    auto previousEnd = currentToken->offset + currentToken->length;
+
+    peekToken(1);
+    currentIndex = (currentIndex + 1) % lookaheadCapacity;
+    lookaheadCount--;
+    currentToken = &tokens[currentIndex];
 
-    if (currentToken.lineNumber != currentLocation.line) {
+    if (currentToken->lineNumber != currentLineNumber) {
         linesChanged = true;
     }
     else {
         linesChanged = false;
     }
 
-    currentLocation.line = currentToken.lineNumber;
-    currentLocation.column = currentToken.columnNumber;
-    currentLocation.file = lexer->getFileName();
+    followsSemicolon = (previousKind == TokenKind::Semicolon);
+
+    if (not followsSemicolon) {
+        lastTokenEnd = previousEnd;
+    }
+
+    currentLineNumber = currentToken->lineNumber;
+    currentLocation = Location(lexer->getFileId(), currentToken->offset);
 
-    return currentToken;
+    return *currentToken;
 }
 
 #include "expr_parsing.h"
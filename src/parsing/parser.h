@@ -1,29 +1,229 @@
 #pragma once
 
+#include <array>
+
+// How tightly an operator holds its operands, loosest first. 'Not' and 
+// 'Unary' are the levels of the prefix operators: what follows "not" is 
+// parsed at 'Comparison', and what follows '-', '+' and '~' at 'Power'. 
+// Every binary operator is left associative, '**' included.
+enum class BindingPower {
+    None,
+    Or,
+    And,
+    Not,
+    Comparison,
+    BitwiseOr,
+    BitwiseXor,
+    BitwiseAnd,
+    Shift,
+    Additive,
+    Multiplicative,
+    Unary,
+    Power,
+    Operand, // above every operator: an await expression
+};
+
+constexpr size_t numberOfTokenKinds = 
+    static_cast<size_t>(TokenKind::AssignmentArithmeticAt) + 1;
+
+// the binding power of every token kind as a binary operator; None for 
+// the kinds that are not one
+constexpr std::array<BindingPower, numberOfTokenKinds> binaryBindingPowers = 
+    [] {
+        std::array<BindingPower, numberOfTokenKinds> powers {};
+
+        auto set = [&](TokenKind kind, BindingPower power) {
+            powers[static_cast<size_t>(kind)] = power;
+        };
+
+        set(TokenKind::ConditionalOr, BindingPower::Or);
+        set(TokenKind::ConditionalAnd, BindingPower::And);
+
+        set(TokenKind::RelationalEquals, BindingPower::Comparison);
+        set(TokenKind::RelationalNotEqual, BindingPower::Comparison);
+        set(TokenKind::RelationalIdentical, BindingPower::Comparison);
+        set(TokenKind::RelationalNotIdentical, BindingPower::Comparison);
+        set(TokenKind::RelationalGreaterThan, BindingPower::Comparison);
+        set(TokenKind::RelationalGreaterThanOrEquals, BindingPower::Comparison);
+        set(TokenKind::RelationalLesserThan, BindingPower::Comparison);
+        set(TokenKind::RelationalLesserThanOrEquals, BindingPower::Comparison);
+        set(TokenKind::RelationalIsContainedIn, BindingPower::Comparison);
+        set(TokenKind::RelationalIsNotContainedIn, BindingPower::Comparison);
+
+        set(TokenKind::LogicalOr, BindingPower::BitwiseOr);
+        set(TokenKind::LogicalXor, BindingPower::BitwiseXor);
+        set(TokenKind::LogicalAnd, BindingPower::BitwiseAnd);
+
+        set(TokenKind::LogicalLeftShift, BindingPower::Shift);
+        set(TokenKind::LogicalRightShift, BindingPower::Shift);
+
+        set(TokenKind::ArithmeticAdd, BindingPower::Additive);
+        set(TokenKind::ArithmeticSub, BindingPower::Additive);
+
+        set(TokenKind::ArithmeticMul, BindingPower::Multiplicative);
+        set(TokenKind::ArithmeticDiv, BindingPower::Multiplicative);
+        set(TokenKind::ArithmeticFloorDiv, BindingPower::Multiplicative);
+        set(TokenKind::ArithmeticMod, BindingPower::Multiplicative);
+        set(TokenKind::At, BindingPower::Multiplicative);
+
+        set(TokenKind::ArithmeticPow, BindingPower::Power);
+        return powers;
+    }();
+
 class Parser {
 public:
-    Parser(Lexer* lexer)
-        : lexer(lexer) {
+    // every node the parser makes is owned by 'arena'; syntax errors are 
+    // reported to 'diagnostics'
+    Parser(Lexer* lexer, Arena* arena, Diagnostics* diagnostics)
+        : arena(arena),
+        lexer(lexer),
+        diagnostics(diagnostics) {
             fetchToken();
         }
 
     void parseStmtList(StmtList&);
 
+    // After a syntax error, skips to the next statement and goes on 
+    // parsing; the broken statement becomes an ErrorStmt. Without this the 
+    // first error ends the parse (FatalError).
+    void enableErrorRecovery() {
+        recoverFromErrors = true;
+    }
+
+    // Makes code nested deeper than 'depth' levels a syntax error. A level 
+    // is a bracket, a block, a lambda or a link in a chain of attributes, 
+    // calls and subscriptions; each one takes a few hundred bytes of stack 
+    // while it is being parsed, and worker threads have less stack than 
+    // the main thread.
+    void setMaxNestingDepth(size_t depth) {
+        maxNestingDepth = depth;
+    }
+
+    // Makes every block indented 'scheme' deeper than the one around it, 
+    // where the parse would otherwise take the indentation of the first 
+    // block it meets; for a parse of part of a file, whose first block may 
+    // come before that part.
+    void setIndentationScheme(int scheme) {
+        indentationScheme = scheme;
+    }
+
+    // Steps over the body of every function with the lexer alone, and 
+    // leaves it to be parsed by FuncdefStmt::getSuite() when it is first 
+    // asked for. The lexer, the arena and the diagnostics must then outlive 
+    // the statements. Parsing a body moves the lexer, so bodies are only 
+    // asked for once the statements are all parsed, and from one thread at 
+    // a time: every body of a parse shares its lexer and arena. Before the 
+    // statements go to other threads, parseAllBodies() parses them all. 
+    // Syntax errors in a body are only found when it is parsed.
+    void enableLazyFunctionBodies() {
+        lazyFunctionBodies = true;
+    }
+
+    static constexpr size_t defaultMaxNestingDepth = 1000;
+
 private:
+    // What it takes to parse a skipped function body later: where its ':' 
+    // is, and the state the parser was in there.
+    class LazyFunctionBody final : public LazySuite {
+    public:
+        void parseInto(Suite& suite) override;
+
+        Lexer* lexer;
+        Arena* arena;
+        Diagnostics* diagnostics;
+
+        size_t colonOffset;
+        size_t colonLineNumber;
+        size_t colonColumnNumber;
+        size_t endOffset;
+
+        uint64_t indentation;
+        int indentationScheme;
+        size_t nestingDepth;
+        size_t maxNestingDepth;
+        bool recoverFromErrors;
+    };
+
+    LazySuite* skipSuite(uint64_t indentation);
+
+    // Counts the levels of nesting entered by a parse function, and leaves 
+    // them when the function returns or throws.
+    class NestingGuard {
+    public:
+        explicit NestingGuard(Parser* parser, size_t levels = 1)
+            : parser(parser) {
+                for (size_t i = 0; i < levels; ++i) {
+                    enter();
+                }
+            }
+
+        NestingGuard(const NestingGuard&) = delete;
+
+        ~NestingGuard() {
+            parser->nestingDepth -= levels;
+        }
+
+        void enter() {
+            if (parser->nestingDepth == parser->maxNestingDepth) {
+                parser->reportNestingTooDeep();
+            }
+
+            parser->nestingDepth++;
+            levels++;
+        }
+
+    private:
+        Parser* parser;
+        size_t levels {0};
+    };
+
+    [[noreturn]] void reportNestingTooDeep() const;
+
     bool matchToken(TokenKind kind) const;
-    bool matchToken(const std::string& value) const;
+    bool matchToken(std::string_view value) const;
 
     bool skipOptionalToken(TokenKind kind);
-    bool skipOptionalToken(const std::string& value);
+    bool skipOptionalToken(std::string_view value);
 
     void requireToken(TokenKind kind) const;
-    void requireToken(const std::string& value) const;
+    void requireToken(std::string_view value) const;
 
     void skipRequiredToken(TokenKind kind);
-    void skipRequiredToken(const std::string& value);
+    void skipRequiredToken(std::string_view value);
 
     Token& fetchToken();
 
+    // the token 'distance' places after the current one, which stays 
+    // current; 'distance' must be less than lookaheadCapacity
+    const Token& peekToken(size_t distance);
+    void readToken(Token&);
+
+    // whether the current token starts a new simple statement, either on 
+    // a new line or after a ';' on the same one
+    bool atStmtBoundary() const {
+        return linesChanged || followsSemicolon;
+    }
+
+    // Gives a node that has just been parsed the source range from 'begin' 
+    // to the end of the last token taken.
+    template <typename Node>
+    Node* endNode(Node* node, uint32_t begin) {
+        node->range = SourceRange(begin, lastTokenEnd);
+        return node;
+    }
+
+    template <typename Node>
+    Node* endNode(Node* node) {
+        return endNode(node, node->location.offset);
+    }
+
+    // whether the simple statement being parsed has no more tokens
+    bool atEndOfSimpleStmt() const {
+        return linesChanged 
+            || matchToken(TokenKind::Semicolon) 
+            || matchToken(TokenKind::EndOfFile);
+    }
+
     std::string parseName();
 
     // Expression parsing
@@ -55,17 +255,8 @@ private:
     ExprPtr parseSliceCallAttrSubsExpr();
 
     ExprPtr parseAwaitExpr();
-    ExprPtr parseExponentiationExpr();
-    ExprPtr parseUnaryExpr();
-    ExprPtr parseMultiplicativeExpr();
-    ExprPtr parseAdditiveExpr();
-    ExprPtr parseShiftExpr();
-    ExprPtr parseBitwiseAndExpr();
-    ExprPtr parseBitwiseXorExpr();
-    ExprPtr parseBitwiseOrExpr();
-    ExprPtr parseComparisonExpr();
-    ExprPtr parseBooleanNotExpr();
-    ExprPtr parseBooleanAndExpr();
+    BindingPower getBinaryBindingPower() const;
+    ExprPtr parseOperatorExpr(BindingPower);
     ExprPtr parseBooleanOrExpr();
     ExprPtr parseLambdaExpr();
 
@@ -91,21 +282,40 @@ private:
     StmtPtr parseWithStmt(uint64_t);
     StmtPtr parseFuncdefStmt(uint64_t);
     StmtPtr parseClassdefStmt(uint64_t);
-    StmtPtr parseStmt(uint64_t);
+    StmtPtr parseStmt(uint64_t, uint32_t&);
 
     void parseParameterList(ParameterList&);
     void parseArgumentList(ArgumentList&);
     void parseDecoratorList(DecoratorList&);
     void parseSuite(Suite&, uint64_t);
 
-    Token currentToken;
-    std::vector<Token> tokenBuffer;
+    StmtPtr recoverFromError(const Location&, uint32_t, uint64_t);
+
+    // The current token and the ones peeked at after it, in a ring; 
+    // taking the next token only moves 'currentIndex' on.
+    static constexpr size_t lookaheadCapacity = 4;
+    Token tokens[lookaheadCapacity];
+    size_t currentIndex {0};
+    size_t lookaheadCount {0}; // tokens read after the current one
+    Token* currentToken {&tokens[0]};
 
     Location currentLocation;
+    size_t currentLineNumber {0};
 
     bool linesChanged {false};
+    bool followsSemicolon {false};
+    uint32_t lastTokenEnd {0}; // of the last token taken other than ';'
     int indentationScheme {0};
     bool parsingParenthesizedExpr = false;
 
+    bool recoverFromErrors {false};
+    bool lazyFunctionBodies {false};
+    int bracketDepth {0}; // of all the tokens read so far
+
+    size_t nestingDepth {0};
+    size_t maxNestingDepth {defaultMaxNestingDepth};
+
+    Arena* arena;
     Lexer* lexer;
+    Diagnostics* diagnostics;
 };
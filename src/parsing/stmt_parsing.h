@@ -12,7 +12,7 @@ void Parser::parseParameterList(ParameterList& list) {
         }
 
         requireToken(TokenKind::Identifier);
-        param.name = currentToken.value;
+        param.name = currentToken->value;
         fetchToken();
 
         if (skipOptionalToken(TokenKind::Colon)) {
@@ -42,24 +42,35 @@ void Parser::parseArgumentList(ArgumentList& list) {
             argument.value = parseExpr();
             list.push_back(std::move(argument));
         }
+        else if (
+            matchToken(TokenKind::Identifier)
+            && (peekToken(1).kind == TokenKind::Assignment)
+        ) {
+            // a keyword argument; the name never becomes an expression
+            argument.name = currentToken->value;
+            fetchToken();
+            fetchToken();// skip "="
+            argument.value = parseExpr();
+            list.push_back(std::move(argument));
+        }
         else {
             auto tempArgument = parseExpr();
             if (matchToken("=")) {
                 if (tempArgument->kind != ExprKind::Name) {
-                    ErrorReporter::reportFatalError(
+                    diagnostics->reportFatalError(
                         "Unexpected '=' after non-name expression",
                         currentLocation
                     );
                 }
 
                 if (tempArgument->await) {
-                    ErrorReporter::reportFatalError(
+                    diagnostics->reportFatalError(
                         "Unexpected '=' after non-name expression",
                         currentLocation
                     );
                 }
 
-                argument.name = std::static_pointer_cast<NameExpr>(
+                argument.name = static_cast<NameExpr*>(
                     tempArgument
                 )->value;
 
@@ -90,7 +101,7 @@ void Parser::parseDecoratorList(DecoratorList& list) {
         }
 
         if (not linesChanged) {
-            ErrorReporter::reportFatalError(
+            diagnostics->reportFatalError(
                 "Expected a newline here",
                 currentLocation
             );
@@ -100,19 +111,26 @@ void Parser::parseDecoratorList(DecoratorList& list) {
     } while (skipOptionalToken(TokenKind::At));
 }
 
-StmtPtr Parser::parseStmt(uint64_t indentation) {
-    if (currentToken.virtualOffset > indentation) {
-        ErrorReporter::reportFatalError(
+// 'begin' is set to the offset of the statement's first token, which comes 
+// after any string statements that are skipped
+StmtPtr Parser::parseStmt(uint64_t indentation, uint32_t& begin) {
+    begin = currentToken->offset;
+
+    // after a ';' the statement shares its sibling's line and suite
+    bool sharesLine = followsSemicolon && not linesChanged;
+
+    if (not sharesLine && currentToken->virtualOffset > indentation) {
+        diagnostics->reportFatalError(
             "Unexpected indentation while parsing statement",
             currentLocation
         );
     }
-    else if (indentation > currentToken.virtualOffset) {
+    else if (not sharesLine && indentation > currentToken->virtualOffset) {
         return nullptr;
     }
 
     if (matchToken(TokenKind::EndOfFile)) {
-        auto stmt = std::make_shared<Stmt>(
+        auto stmt = arena->make<Stmt>(
             currentLocation, 
             StmtKind::None
         );
@@ -181,10 +199,10 @@ StmtPtr Parser::parseStmt(uint64_t indentation) {
         DecoratorList decorators;
         parseDecoratorList(decorators);
 
-        switch (currentToken.kind) {
+        switch (currentToken->kind) {
         case TokenKind::KeywordDef: {
             auto stmt = 
-                std::static_pointer_cast<FuncdefStmt>(
+                static_cast<FuncdefStmt*>(
                     parseFuncdefStmt(indentation)
                 );
             stmt->decorators = std::move(decorators);
@@ -192,25 +210,26 @@ StmtPtr Parser::parseStmt(uint64_t indentation) {
         }
         case TokenKind::KeywordClass: {
             auto stmt = 
-                std::static_pointer_cast<ClassdefStmt>(
+                static_cast<ClassdefStmt*>(
                     parseClassdefStmt(indentation)
                 );
             stmt->decorators = std::move(decorators);
             return stmt;
         }
         default:
-            ErrorReporter::reportFatalError(
+            diagnostics->reportFatalError(
                 formatAsString(
                     "expected 'def' or 'class' after decorator list. Found: ",
-                    currentToken.value
+                    currentToken->value
                 ),
                 currentLocation
             );
         }
     }
     else if (skipOptionalToken(TokenKind::ConstantMultilineString)) {
-        // comment
-        return parseStmt(indentation);
+        // comment; like any simple statement it may end with a ';'
+        skipOptionalToken(TokenKind::Semicolon);
+        return parseStmt(indentation, begin);
     }
     else {
         // assignments and function calls
@@ -222,13 +241,13 @@ StmtPtr Parser::parseStmt(uint64_t indentation) {
 
         if (skipOptionalToken(TokenKind::Colon)) {
             if (exprs.size() != 1) {
-                ErrorReporter::reportFatalError(
+                diagnostics->reportFatalError(
                     "Unexpected expression-list before the ':' token",
                     exprs.front()->location
                 );
             }
 
-            auto stmt = std::make_shared<AnnotatedAssignmentStmt>(
+            auto stmt = arena->make<AnnotatedAssignmentStmt>(
                 exprs.front()->location
             );
 
@@ -243,7 +262,7 @@ StmtPtr Parser::parseStmt(uint64_t indentation) {
         }
 
         if (skipOptionalToken(TokenKind::Assignment)) {
-            auto stmt = std::make_shared<AssignmentStmt>(
+            auto stmt = arena->make<AssignmentStmt>(
                 exprs.front()->location
             );
 
@@ -251,7 +270,7 @@ StmtPtr Parser::parseStmt(uint64_t indentation) {
             stmt->value = parseExpr();
 
             if (skipOptionalToken(TokenKind::Comma)) {
-                auto tupleExpr = std::make_shared<TupleDisplayExpr>(stmt->value->location);
+                auto tupleExpr = arena->make<TupleDisplayExpr>(stmt->value->location);
                 tupleExpr->items.push_back(stmt->value);
                 tupleExpr->items.push_back(parseExpr());
 
@@ -259,7 +278,10 @@ StmtPtr Parser::parseStmt(uint64_t indentation) {
                     tupleExpr->items.push_back(parseExpr());
                 }
 
-                stmt->value = tupleExpr;
+                stmt->value = endNode(
+                    tupleExpr, 
+                    tupleExpr->items.front()->range.begin
+                );
             }
 
             skipOptionalToken(TokenKind::Semicolon);
@@ -267,13 +289,13 @@ StmtPtr Parser::parseStmt(uint64_t indentation) {
             return stmt;
         }
 
-        if (isAssignment(currentToken.kind)) {
-            auto stmt = std::make_shared<AugmentedAssignmentStmt>(
+        if (isAssignment(currentToken->kind)) {
+            auto stmt = arena->make<AugmentedAssignmentStmt>(
                 exprs.front()->location
             );
 
             stmt->autoTarget = exprs.front();
-            stmt->augOp = currentToken.kind;
+            stmt->augOp = currentToken->kind;
 
             fetchToken();
 
@@ -288,20 +310,20 @@ StmtPtr Parser::parseStmt(uint64_t indentation) {
             assert(exprs.size() >= 1);
 
             if (exprs.size() != 1) {
-                ErrorReporter::reportFatalError(
+                diagnostics->reportFatalError(
                     "Unexpected expression-list in statement context",
                     exprs.front()->location
                 );
             }
             else {
                 if (exprs.front()->kind != ExprKind::Call) {
-                    ErrorReporter::reportFatalError(
+                    diagnostics->reportFatalError(
                         "Unexpected non-call expression in statement context",
                         exprs.front()->location
                     );
                 }
                 else {
-                    auto stmt = std::make_shared<ExprStmt>(
+                    auto stmt = arena->make<ExprStmt>(
                         exprs.front()->location
                     );
                     
@@ -318,7 +340,7 @@ StmtPtr Parser::parseStmt(uint64_t indentation) {
 }
 
 StmtPtr Parser::parseAssertStmt() {
-    auto stmt = std::make_shared<AssertStmt>(currentLocation);
+    auto stmt = arena->make<AssertStmt>(currentLocation);
     fetchToken();
 
     stmt->expr1 = parseExpr();
@@ -332,20 +354,20 @@ StmtPtr Parser::parseAssertStmt() {
 }
 
 StmtPtr Parser::parsePassStmt() {
-    auto stmt = std::make_shared<Stmt>(currentLocation, StmtKind::Pass);
+    auto stmt = arena->make<Stmt>(currentLocation, StmtKind::Pass);
     fetchToken();
     skipOptionalToken(TokenKind::Semicolon);
     return stmt;
 }
 
 StmtPtr Parser::parseDelStmt() {
-    auto stmt = std::make_shared<DelStmt>(currentLocation);
+    auto stmt = arena->make<DelStmt>(currentLocation);
     fetchToken();
 
     while (1) {
         stmt->targetList.push_back(parseTarget());
 
-        if (linesChanged) {
+        if (atEndOfSimpleStmt()) {
             break;
         }
 
@@ -361,10 +383,10 @@ StmtPtr Parser::parseDelStmt() {
 }
 
 StmtPtr Parser::parseReturnStmt() {
-    auto stmt = std::make_shared<ReturnStmt>(currentLocation);
+    auto stmt = arena->make<ReturnStmt>(currentLocation);
     fetchToken();
 
-    if (linesChanged) {
+    if (atEndOfSimpleStmt()) {
         skipOptionalToken(TokenKind::Semicolon);
         return stmt;
     }
@@ -388,17 +410,17 @@ StmtPtr Parser::parseReturnStmt() {
 }
 
 StmtPtr Parser::parseYieldStmt() {
-    auto stmt = std::make_shared<YieldStmt>(currentLocation);
+    auto stmt = arena->make<YieldStmt>(currentLocation);
     stmt->expr = parseYieldExpr();
     skipOptionalToken(TokenKind::Semicolon);
     return stmt;
 }
 
 StmtPtr Parser::parseRaiseStmt() {
-    auto stmt = std::make_shared<RaiseStmt>(currentLocation);
+    auto stmt = arena->make<RaiseStmt>(currentLocation);
     fetchToken();
 
-    if (linesChanged) {
+    if (atEndOfSimpleStmt()) {
         skipOptionalToken(TokenKind::Semicolon);
         return stmt;
     }
@@ -414,21 +436,21 @@ StmtPtr Parser::parseRaiseStmt() {
 }
 
 StmtPtr Parser::parseBreakStmt() {
-    auto stmt = std::make_shared<Stmt>(currentLocation, StmtKind::Break);
+    auto stmt = arena->make<Stmt>(currentLocation, StmtKind::Break);
     fetchToken();
     skipOptionalToken(TokenKind::Semicolon);
     return stmt;
 }
 
 StmtPtr Parser::parseContinueStmt() {
-    auto stmt = std::make_shared<Stmt>(currentLocation, StmtKind::Continue);
+    auto stmt = arena->make<Stmt>(currentLocation, StmtKind::Continue);
     fetchToken();
     skipOptionalToken(TokenKind::Semicolon);
     return stmt;
 }
 
 StmtPtr Parser::parseImportStmt() {
-    auto stmt = std::make_shared<ImportStmt>(currentLocation);
+    auto stmt = arena->make<ImportStmt>(currentLocation);
     fetchToken();
 
     while (1) {
@@ -442,7 +464,7 @@ StmtPtr Parser::parseImportStmt() {
 
         do {
             if (matchToken(TokenKind::Identifier)) {
-                item.parts.push_back(currentToken.value);
+                item.parts.emplace_back(currentToken->value);
                 fetchToken();
                 metAtLeastOneName = true;
             }
@@ -452,7 +474,7 @@ StmtPtr Parser::parseImportStmt() {
         } while (skipOptionalToken(TokenKind::Access));
 
         if (not metAtLeastOneName) {
-            ErrorReporter::reportFatalError(
+            diagnostics->reportFatalError(
                 "Expected an import item. Invalid syntax.",
                 currentLocation
             );
@@ -460,7 +482,7 @@ StmtPtr Parser::parseImportStmt() {
 
         if (skipOptionalToken("as")) {
             requireToken(TokenKind::Identifier);
-            item.alias = currentToken.value;
+            item.alias = currentToken->value;
             fetchToken();
         }
 
@@ -476,7 +498,7 @@ StmtPtr Parser::parseImportStmt() {
 }
 
 StmtPtr Parser::parseFromStmt() {
-    auto stmt = std::make_shared<ImportStmt>(currentLocation);
+    auto stmt = arena->make<ImportStmt>(currentLocation);
     fetchToken();
 
     while (skipOptionalToken(TokenKind::Access)) {
@@ -487,7 +509,7 @@ StmtPtr Parser::parseFromStmt() {
 
     do {
         if (matchToken(TokenKind::Identifier)) {
-            stmt->source.push_back(currentToken.value);
+            stmt->source.emplace_back(currentToken->value);
             fetchToken();
             metAtLeastOneName = true;
         }
@@ -497,7 +519,7 @@ StmtPtr Parser::parseFromStmt() {
     } while (skipOptionalToken(TokenKind::Access));
 
     if (not metAtLeastOneName) {
-        ErrorReporter::reportFatalError(
+        diagnostics->reportFatalError(
             "Expected an import source. Invalid syntax.",
             currentLocation
         );
@@ -510,7 +532,7 @@ StmtPtr Parser::parseFromStmt() {
 
         ImportItem item;
         
-        item.parts.push_back(currentToken.value);
+        item.parts.emplace_back(currentToken->value);
         fetchToken();
 
         if (skipOptionalToken(TokenKind::KeywordAs)) {
@@ -526,12 +548,12 @@ StmtPtr Parser::parseFromStmt() {
 }
 
 StmtPtr Parser::parseGlobalStmt() {
-    auto stmt = std::make_shared<GlobalStmt>(currentLocation);
+    auto stmt = arena->make<GlobalStmt>(currentLocation);
     fetchToken();
 
     while (1) {
         requireToken(TokenKind::Identifier);
-        stmt->names.push_back(currentToken.value);
+        stmt->names.emplace_back(currentToken->value);
         fetchToken();
 
         if (not skipOptionalToken(TokenKind::Comma)) {
@@ -544,12 +566,12 @@ StmtPtr Parser::parseGlobalStmt() {
 }
 
 StmtPtr Parser::parseNonlocalStmt() {
-    auto stmt = std::make_shared<NonlocalStmt>(currentLocation);
+    auto stmt = arena->make<NonlocalStmt>(currentLocation);
     fetchToken();
 
     while (1) {
         requireToken(TokenKind::Identifier);
-        stmt->names.push_back(currentToken.value);
+        stmt->names.emplace_back(currentToken->value);
         fetchToken();
 
         if (not skipOptionalToken(TokenKind::Comma)) {
@@ -562,23 +584,24 @@ StmtPtr Parser::parseNonlocalStmt() {
 }
 
 void Parser::parseSuite(Suite& suite, uint64_t indentation) {
+    NestingGuard guard(this);
     auto& list = suite.stmts;
     skipRequiredToken(TokenKind::Colon);
 
     if (not linesChanged) {
-        ErrorReporter::reportFatalError(
+        diagnostics->reportFatalError(
             formatAsString(
                 "Expected a newline here, but found: ",
-                currentToken.value
+                currentToken->value
             ),
             currentLocation
         );
     }
 
-    const auto blockIndentation = currentToken.virtualOffset;
+    const auto blockIndentation = currentToken->virtualOffset;
 
     if (indentation >= blockIndentation) {
-        ErrorReporter::reportFatalError(
+        diagnostics->reportFatalError(
             "Expected indentation here",
             currentLocation
         );
@@ -588,39 +611,56 @@ void Parser::parseSuite(Suite& suite, uint64_t indentation) {
         indentationScheme = blockIndentation;
     }
 
-    if ((indentation + indentationScheme) != currentToken.virtualOffset) {
-        ErrorReporter::reportFatalError(
+    if ((indentation + indentationScheme) != currentToken->virtualOffset) {
+        diagnostics->reportFatalError(
             "Inconsistent indentation scheme",
             currentLocation
         );
     }
 
     while (1) {
-        auto temp = parseStmt(blockIndentation);
+        auto startLocation = currentLocation;
+        auto startOffset = currentToken->offset;
 
-        if (not temp) {
-            break;
-        }
+        try {
+            uint32_t begin;
+            auto temp = parseStmt(blockIndentation, begin);
 
-        if (temp->kind == StmtKind::None) {
-            break;
+            if (not temp) {
+                break;
+            }
+
+            if (temp->kind == StmtKind::None) {
+                break;
+            }
+
+            endNode(temp, begin);
+
+            if (not atStmtBoundary()) {
+                diagnostics->reportFatalError(
+                    formatAsString(
+                        "Expected a newline here.. right before: ",
+                        currentToken->value
+                    ),
+                    currentLocation
+                );
+            }
+
+            list.push_back(temp);
         }
+        catch (const FatalError&) {
+            if (not recoverFromErrors) {
+                throw;
+            }
 
-        if (not linesChanged) {
-            ErrorReporter::reportFatalError(
-                formatAsString(
-                    "Expected a newline here.. right before: ",
-                    currentToken.value
-                ),
-                currentLocation
+            list.push_back(
+                recoverFromError(startLocation, startOffset, blockIndentation)
             );
         }
-
-        list.push_back(temp);
     }
 
     if (list.size() == 0) {
-        ErrorReporter::reportFatalError(
+        diagnostics->reportFatalError(
             "Expected at least one statement for the suite/block",
             currentLocation
         );
@@ -628,7 +668,7 @@ void Parser::parseSuite(Suite& suite, uint64_t indentation) {
 }
 
 StmtPtr Parser::parseIfStmt(uint64_t indentation) {
-    auto stmt = std::make_shared<IfStmt>(currentLocation);
+    auto stmt = arena->make<IfStmt>(currentLocation);
 
     fetchToken();
 
@@ -637,7 +677,7 @@ StmtPtr Parser::parseIfStmt(uint64_t indentation) {
         stmt->suites.back().first = parseExpr();
         parseSuite(stmt->suites.back().second, indentation);
 
-        if (currentToken.virtualOffset != indentation) {
+        if (currentToken->virtualOffset != indentation) {
             break;
         }
 
@@ -645,7 +685,7 @@ StmtPtr Parser::parseIfStmt(uint64_t indentation) {
             continue;
         }
 
-        if (currentToken.virtualOffset != indentation) {
+        if (currentToken->virtualOffset != indentation) {
             break;
         }
 
@@ -660,14 +700,14 @@ StmtPtr Parser::parseIfStmt(uint64_t indentation) {
 }
 
 StmtPtr Parser::parseWhileStmt(uint64_t indentation) {
-    auto stmt = std::make_shared<WhileStmt>(currentLocation);
+    auto stmt = arena->make<WhileStmt>(currentLocation);
     fetchToken();
 
     stmt->expr = parseExpr();
 
     parseSuite(stmt->suite, indentation);
 
-    if ((not linesChanged) || (currentToken.virtualOffset != indentation)) {
+    if ((not linesChanged) || (currentToken->virtualOffset != indentation)) {
         return stmt;
     }
 
@@ -679,7 +719,7 @@ StmtPtr Parser::parseWhileStmt(uint64_t indentation) {
 }
 
 StmtPtr Parser::parseForStmt(uint64_t indentation) {
-    auto stmt = std::make_shared<ForStmt>(currentLocation);
+    auto stmt = arena->make<ForStmt>(currentLocation);
     fetchToken();
 
     do {
@@ -694,7 +734,7 @@ StmtPtr Parser::parseForStmt(uint64_t indentation) {
 
     parseSuite(stmt->suite, indentation);
 
-    if ((not linesChanged) || (indentation != currentToken.virtualOffset)) {
+    if ((not linesChanged) || (indentation != currentToken->virtualOffset)) {
         return stmt;
     }
 
@@ -706,12 +746,12 @@ StmtPtr Parser::parseForStmt(uint64_t indentation) {
 }
 
 StmtPtr Parser::parseTryStmt(uint64_t indentation) {
-    auto stmt = std::make_shared<TryStmt>(currentLocation);
+    auto stmt = arena->make<TryStmt>(currentLocation);
     fetchToken();
 
     parseSuite(stmt->suite, indentation);
 
-    if ((not linesChanged) || (indentation != currentToken.virtualOffset)) {
+    if ((not linesChanged) || (indentation != currentToken->virtualOffset)) {
         return stmt;
     }
 
@@ -735,7 +775,7 @@ StmtPtr Parser::parseTryStmt(uint64_t indentation) {
 
         if (
             (not linesChanged) 
-            || (indentation != currentToken.virtualOffset)
+            || (indentation != currentToken->virtualOffset)
         ) {
             break;
         }
@@ -750,7 +790,7 @@ StmtPtr Parser::parseTryStmt(uint64_t indentation) {
 
         if (
             (not linesChanged) 
-            || (indentation != currentToken.virtualOffset)
+            || (indentation != currentToken->virtualOffset)
         ) {
             break;
         }
@@ -766,7 +806,7 @@ StmtPtr Parser::parseTryStmt(uint64_t indentation) {
 }
 
 StmtPtr Parser::parseWithStmt(uint64_t indentation) {
-    auto stmt = std::make_shared<WithStmt>(currentLocation);
+    auto stmt = arena->make<WithStmt>(currentLocation);
     fetchToken();
 
     do {
@@ -786,7 +826,7 @@ StmtPtr Parser::parseWithStmt(uint64_t indentation) {
 
 // decorators should have been parsed already, and will be attached later on
 StmtPtr Parser::parseFuncdefStmt(uint64_t indentation) {
-    auto stmt = std::make_shared<FuncdefStmt>(currentLocation);
+    auto stmt = arena->make<FuncdefStmt>(currentLocation);
     fetchToken();
 
     stmt->name = parseName();
@@ -802,12 +842,94 @@ StmtPtr Parser::parseFuncdefStmt(uint64_t indentation) {
         stmt->hint = parseExpr();
     }
 
+    if (lazyFunctionBodies) {
+        stmt->lazySuite = skipSuite(indentation);
+
+        if (stmt->lazySuite) {
+            return stmt;
+        }
+    }
+
     parseSuite(stmt->suite, indentation);
     return stmt;
 }
 
+// Steps over a suite from its ':' with Lexer::skipBlock(), which only 
+// looks at quotes, brackets, comments and line breaks, so this is several 
+// times faster than parsing it. A suite that the lexer does not step over 
+// is parsed instead; parseSuite reports what is wrong with it.
+LazySuite* Parser::skipSuite(uint64_t indentation) {
+    requireToken(TokenKind::Colon);
+
+    // the lexer has gone past tokens already taken from it
+    if (lookaheadCount != 0) {
+        return nullptr;
+    }
+
+    // with no scheme yet, parseSuite takes the block's indentation for it, 
+    // which only checks out at indentation 0; 0 lets the lexer take any
+    auto blockIndentation = indentation + indentationScheme;
+
+    if ((indentationScheme == 0) && (indentation != 0)) {
+        return nullptr;
+    }
+
+    Lexer::SkippedBlock block;
+
+    if (not lexer->skipBlock(indentation, blockIndentation, block)) {
+        return nullptr;
+    }
+
+    if (indentationScheme == 0) {
+        indentationScheme = block.indentation;
+    }
+
+    auto body = arena->make<LazyFunctionBody>();
+    body->lexer = lexer;
+    body->arena = arena;
+    body->diagnostics = diagnostics;
+    body->colonOffset = currentToken->offset;
+    body->colonLineNumber = currentToken->lineNumber;
+    body->colonColumnNumber = currentToken->columnNumber;
+    body->endOffset = block.endOffset;
+    body->indentation = indentation;
+    body->indentationScheme = indentationScheme;
+    body->nestingDepth = nestingDepth;
+    body->maxNestingDepth = maxNestingDepth;
+    body->recoverFromErrors = recoverFromErrors;
+
+    // a bad token after the body goes with the statement it starts, which 
+    // then takes the error
+    try {
+        fetchToken();
+    }
+    catch (const FatalError&) {
+        if (not recoverFromErrors) {
+            throw;
+        }
+        fetchToken();
+    }
+
+    lastTokenEnd = block.contentEnd;
+
+    return body;
+}
+
+void Parser::LazyFunctionBody::parseInto(Suite& suite) {
+    lexer->seek(colonOffset, colonLineNumber, colonColumnNumber, endOffset);
+
+    Parser parser(lexer, arena, diagnostics);
+    parser.indentationScheme = indentationScheme;
+    parser.nestingDepth = nestingDepth;
+    parser.maxNestingDepth = maxNestingDepth;
+    parser.recoverFromErrors = recoverFromErrors;
+    parser.lazyFunctionBodies = true;
+
+    parser.parseSuite(suite, indentation);
+}
+
 StmtPtr Parser::parseClassdefStmt(uint64_t indentation) {
-    auto stmt = std::make_shared<ClassdefStmt>(currentLocation);
+    auto stmt = arena->make<ClassdefStmt>(currentLocation);
     fetchToken();
 
     stmt->name = parseName();
@@ -823,30 +945,138 @@ StmtPtr Parser::parseClassdefStmt(uint64_t indentation) {
 
 void Parser::parseStmtList(StmtList& list) {
     while (1) {
-        auto temp = parseStmt(0);
-        
-        if (not temp) {
-            ErrorReporter::reportFatalError(
-                formatAsString(
-                    "Unexpected indentation before '",
-                    toString(currentToken.kind),
-                    "'"
-                ),
-                currentLocation
-            );                
+        auto startLocation = currentLocation;
+        auto startOffset = currentToken->offset;
+
+        try {
+            uint32_t begin;
+            auto temp = parseStmt(0, begin);
+            
+            if (not temp) {
+                diagnostics->reportFatalError(
+                    formatAsString(
+                        "Unexpected indentation before '",
+                        toString(currentToken->kind),
+                        "'"
+                    ),
+                    currentLocation
+                );                
+            }
+
+            endNode(temp, begin);
+
+            if (not matchToken(TokenKind::EndOfFile) && not atStmtBoundary()) {
+                diagnostics->reportFatalError(
+                    "Expected a newline here",
+                    currentLocation
+                );
+            }
+
+            list.push_back(temp);
         }
+        catch (const FatalError&) {
+            if (not recoverFromErrors) {
+                throw;
+            }
 
-        list.push_back(temp);
+            list.push_back(recoverFromError(startLocation, startOffset, 0));
+        }
 
         if (matchToken(TokenKind::EndOfFile)) {
             break;
         }
+    }
+}
 
-        if (not linesChanged) {
-            ErrorReporter::reportFatalError(
-                "Expected a newline here",
-                currentLocation
-            );
+// keywords that never appear inside an expression
+static bool startsStatementOnly(TokenKind kind) {
+    switch (kind) {
+    case TokenKind::KeywordDef:
+    case TokenKind::KeywordClass:
+    case TokenKind::KeywordWhile:
+    case TokenKind::KeywordTry:
+    case TokenKind::KeywordExcept:
+    case TokenKind::KeywordFinally:
+    case TokenKind::KeywordElif:
+    case TokenKind::KeywordWith:
+    case TokenKind::KeywordImport:
+    case TokenKind::KeywordReturn:
+    case TokenKind::KeywordPass:
+    case TokenKind::KeywordBreak:
+    case TokenKind::KeywordContinue:
+    case TokenKind::KeywordRaise:
+    case TokenKind::KeywordGlobal:
+    case TokenKind::KeywordNonlocal:
+    case TokenKind::KeywordAssert:
+    case TokenKind::KeywordDel:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief      Skips the rest of a statement that had a syntax error: 
+ *             everything up to the first line that is indented less than 
+ *             the statement, or as much as it and either outside of any 
+ *             brackets or starting with a keyword that can only begin a 
+ *             statement. The last two keep an unclosed bracket from 
+ *             swallowing the rest of the file.
+ *
+ * @param[in]  location     Where the statement started.
+ * @param[in]  startOffset  The offset at which the statement started.
+ * @param[in]  indentation  The indentation of the statement.
+ *
+ * @return     An ErrorStmt holding the skipped source.
+ */
+StmtPtr Parser::recoverFromError(
+    const Location& location, 
+    uint32_t startOffset, 
+    uint64_t indentation
+) {
+    parsingParenthesizedExpr = false;
+
+    while (not matchToken(TokenKind::EndOfFile)) {
+        if (linesChanged && (currentToken->offset != startOffset)) {
+            uint64_t lineIndentation = currentToken->virtualOffset;
+
+            if (lineIndentation < indentation) {
+                break;
+            }
+
+            if (
+                (lineIndentation == indentation) 
+                && (
+                    (bracketDepth <= 0) 
+                    || startsStatementOnly(currentToken->kind)
+                )
+            ) {
+                break;
+            }
+        }
+
+        // errors from the lexer have been reported already; keep going
+        while (1) {
+            try {
+                fetchToken();
+                break;
+            }
+            catch (const FatalError&) {}
         }
     }
+
+    bracketDepth = 0;
+
+    auto text = lexer->getSource().substr(
+        startOffset, 
+        currentToken->offset - startOffset
+    );
+
+    while (not text.empty() && isspace(static_cast<unsigned char>(text.back()))) {
+        text.remove_suffix(1);
+    }
+
+    auto stmt = arena->make<ErrorStmt>(location);
+    stmt->text = std::string(text);
+    return stmt;
 }